@@ -0,0 +1,131 @@
+// Micro-benchmark for the vertex deformation in ofApp::updatePregeom.
+//
+// "reference" mirrors the original loop: a scale + translate matrix and three
+// sin() calls per vertex, applied with ofMatrix4x4::postMult semantics.
+// "scalar" and "simd" are the kernels from src/DeformKernel.h.
+//
+//   make -C bench && bench/deform_bench [vertices]
+
+#include "../src/DeformKernel.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+namespace {
+
+const float AUDIO_SCALING = 160.0f;
+
+// Row-major 4x4 like ofMatrix4x4, translation in the last row
+struct Matrix {
+    float m[4][4];
+};
+
+void referenceUpdate(const deform::Positions& in, deform::Positions& out, const float* bins, int numBins, float size) {
+    float fileScale = size / 300000.0f;
+    float fileScaleOrg = fileScale;
+    fileScale = std::min(std::max(fileScale, 0.4f), 1.0f);
+
+    int n = in.size();
+    for (int i = 0; i < n; ++i) {
+        int fftIndex = static_cast<int>(static_cast<float>(i) / n * (numBins - 1));
+        fftIndex = std::min(std::max(fftIndex, 0), numBins - 1);
+        float fftValue = numBins == 0 ? 1 : bins[fftIndex] * AUDIO_SCALING;
+
+        float scaleValue = fileScale * (1.0 + fftValue * 0.1);
+        Matrix t = {{{scaleValue, 0, 0, 0}, {0, scaleValue, 0, 0}, {0, 0, scaleValue, 0}, {0, 0, 0, 1}}};
+
+        float randoms2[3] = {
+            std::sin((2 + i) * fileScaleOrg * 413.0f + 0.1f) / 2.0f + 0.5f + fftValue * 0.1f,
+            std::sin((2 + i) * fileScaleOrg * 543.0f + 0.2f) / 2.0f + 0.5f + fftValue * 0.1f,
+            std::sin((2 + i) * fileScaleOrg * 123.0f + 0.3f) / 2.0f + 0.5f + fftValue * 0.1f
+        };
+        t.m[3][0] += (randoms2[1] - 0.5f) * 100.0f * fileScale;
+        t.m[3][1] += (randoms2[0] - 0.5f) * 100.0f * fileScale;
+        t.m[3][2] += (randoms2[2] - 0.5f) * 100.0f * fileScale;
+
+        float v[4] = {in.x[i], in.y[i], in.z[i], 1.0f};
+        float r[3];
+        for (int row = 0; row < 3; ++row) {
+            r[row] = t.m[row][0] * v[0] + t.m[row][1] * v[1] + t.m[row][2] * v[2] + t.m[row][3] * v[3];
+        }
+        out.x[i] = r[0];
+        out.y[i] = r[1];
+        out.z[i] = r[2];
+    }
+}
+
+template <typename F>
+double millisPerRun(int runs, F&& f) {
+    f(); // warm up
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < runs; ++r) {
+        f();
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / runs;
+}
+
+float maxError(const deform::Positions& a, const deform::Positions& b) {
+    float err = 0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        err = std::max(err, std::abs(a.x[i] - b.x[i]));
+        err = std::max(err, std::abs(a.y[i] - b.y[i]));
+        err = std::max(err, std::abs(a.z[i] - b.z[i]));
+    }
+    return err;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 4 * 1024 * 1024;
+    const int numBins = 8193; // ofxEasyFft bins for a 16384 window
+    const float size = 3945123;
+    const int runs = 10;
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> position(-300.0f, 300.0f);
+    std::uniform_real_distribution<float> magnitude(0.0f, 1.0f);
+
+    deform::Positions in, reference, scalar, simd;
+    in.resize(n);
+    reference.resize(n);
+    scalar.resize(n);
+    simd.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        in.x[i] = position(rng);
+        in.y[i] = position(rng);
+        in.z[i] = position(rng);
+    }
+    std::vector<float> bins(numBins);
+    for (auto& bin : bins) {
+        bin = magnitude(rng) * magnitude(rng) * 0.05f;
+    }
+
+    deform::Params params;
+    params.bins = bins.data();
+    params.numBins = numBins;
+    params.fileScale = deform::fileScaleForSize(size);
+    params.audioScaling = AUDIO_SCALING;
+
+    double referenceMs = millisPerRun(runs, [&] { referenceUpdate(in, reference, bins.data(), numBins, size); });
+    double scalarMs = millisPerRun(runs, [&] { deform::scaleScalar(in, scalar.span(), params, 0, n); });
+    double simdMs = millisPerRun(runs, [&] { deform::scale(in, simd.span(), params); });
+
+#if defined(__AVX2__)
+    const char* simdName = "avx2";
+#elif defined(__SSE2__) || defined(_M_X64)
+    const char* simdName = "sse2";
+#else
+    const char* simdName = "none";
+#endif
+
+    std::printf("%zu vertices, %d runs\n", n, runs);
+    std::printf("  reference  %8.2f ms  %6.2f ns/vertex\n", referenceMs, referenceMs * 1e6 / n);
+    std::printf("  scalar     %8.2f ms  %6.2f ns/vertex  (%.1fx)  max error %g\n", scalarMs, scalarMs * 1e6 / n, referenceMs / scalarMs, maxError(reference, scalar));
+    std::printf("  %-8s   %8.2f ms  %6.2f ns/vertex  (%.1fx)  max error %g\n", simdName, simdMs, simdMs * 1e6 / n, referenceMs / simdMs, maxError(reference, simd));
+    return 0;
+}
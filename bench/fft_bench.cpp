@@ -0,0 +1,141 @@
+// Micro-benchmark for the real FFT backends behind AudioAnalyzer.
+//
+// "textbook" is an in-place complex radix-2 FFT of the real signal with bit
+// reversal and per-pass twiddle recurrences, the same shape of algorithm as
+// ofxFft's OF_FFT_BASIC, standing in for it since ofxFft needs
+// openFrameworks. "scalar" and "simd" are realfft::Plan from src/RealFft.h.
+// Errors are relative to a double precision reference.
+//
+//   make -C bench && bench/fft_bench [runs]
+
+#include "../src/RealFft.h"
+
+#include <algorithm>
+#include <chrono>
+#include <complex>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+namespace {
+
+void referenceFft(std::vector<std::complex<double>>& x) {
+    size_t n = x.size();
+    if (n == 1) {
+        return;
+    }
+    std::vector<std::complex<double>> even(n / 2), odd(n / 2);
+    for (size_t i = 0; i < n / 2; ++i) {
+        even[i] = x[2 * i];
+        odd[i] = x[2 * i + 1];
+    }
+    referenceFft(even);
+    referenceFft(odd);
+    for (size_t k = 0; k < n / 2; ++k) {
+        std::complex<double> t = std::polar(1.0, -2.0 * M_PI * k / n) * odd[k];
+        x[k] = even[k] + t;
+        x[k + n / 2] = even[k] - t;
+    }
+}
+
+void textbookFft(std::vector<float>& re, std::vector<float>& im) {
+    size_t n = re.size();
+    for (size_t i = 1, j = 0; i < n; ++i) {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            std::swap(re[i], re[j]);
+            std::swap(im[i], im[j]);
+        }
+    }
+    for (size_t length = 2; length <= n; length *= 2) {
+        double angle = -2.0 * M_PI / length;
+        float stepRe = std::cos(angle);
+        float stepIm = std::sin(angle);
+        for (size_t i = 0; i < n; i += length) {
+            float wr = 1, wi = 0;
+            for (size_t j = 0; j < length / 2; ++j) {
+                size_t a = i + j;
+                size_t b = a + length / 2;
+                float tr = re[b] * wr - im[b] * wi;
+                float ti = re[b] * wi + im[b] * wr;
+                re[b] = re[a] - tr;
+                im[b] = im[a] - ti;
+                re[a] += tr;
+                im[a] += ti;
+                float next = wr * stepRe - wi * stepIm;
+                wi = wr * stepIm + wi * stepRe;
+                wr = next;
+            }
+        }
+    }
+}
+
+template <typename F>
+double microsPerRun(int runs, F&& f) {
+    f(); // warm up
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < runs; ++r) {
+        f();
+    }
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / runs;
+}
+
+// Largest deviation from the reference over its peak magnitude
+double relativeError(const std::vector<std::complex<double>>& reference, const float* re, const float* im, size_t bins) {
+    double peak = 0, error = 0;
+    for (size_t k = 0; k < bins; ++k) {
+        peak = std::max(peak, std::abs(reference[k]));
+        error = std::max(error, std::abs(reference[k] - std::complex<double>(re[k], im[k])));
+    }
+    return error / peak;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int runs = argc > 1 ? std::atoi(argv[1]) : 200;
+
+#if defined(__SSE2__) || defined(_M_X64)
+    const char* simdName = "sse2";
+#else
+    const char* simdName = "none";
+#endif
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> sample(-1.0f, 1.0f);
+
+    std::printf("us per transform, %d runs, error relative to the peak bin\n", runs);
+    std::printf("%8s  %10s  %10s  %10s  %8s  %10s  %10s\n", "size", "textbook", "scalar", simdName, "speedup", "err scalar", "err simd");
+    for (size_t n = 1024; n <= 32768; n *= 2) {
+        std::vector<float> signal(n);
+        for (auto& s : signal) {
+            s = sample(rng);
+        }
+
+        std::vector<std::complex<double>> reference(signal.begin(), signal.end());
+        referenceFft(reference);
+
+        std::vector<float> re(n), im(n);
+        double textbookUs = microsPerRun(runs, [&] {
+            std::copy(signal.begin(), signal.end(), re.begin());
+            std::fill(im.begin(), im.end(), 0.0f);
+            textbookFft(re, im);
+        });
+
+        realfft::Plan plan(n);
+        std::vector<float> scalarRe(plan.bins()), scalarIm(plan.bins());
+        std::vector<float> simdRe(plan.bins()), simdIm(plan.bins());
+        double scalarUs = microsPerRun(runs, [&] { plan.forwardScalar(signal.data(), scalarRe.data(), scalarIm.data()); });
+        double simdUs = microsPerRun(runs, [&] { plan.forward(signal.data(), simdRe.data(), simdIm.data()); });
+
+        std::printf("%8zu  %10.1f  %10.1f  %10.1f  %7.1fx  %10.2g  %10.2g\n", n, textbookUs, scalarUs, simdUs, textbookUs / simdUs,
+                    relativeError(reference, scalarRe.data(), scalarIm.data(), plan.bins()),
+                    relativeError(reference, simdRe.data(), simdIm.data(), plan.bins()));
+    }
+    return 0;
+}
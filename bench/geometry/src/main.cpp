@@ -0,0 +1,147 @@
+// Deterministic, CPU-only benchmark of the geometry pipeline. It builds the
+// shape library with ofApp::generateGeometries(), a scene with
+// ofApp::setupGeometry() and then times ofApp::rebuildGeometry(), the CPU
+// path's per-frame mesh rebuild, against bands analyzed from a synthetic
+// signal. Needs no window, GL context or audio device.
+//
+//   make -C bench/geometry Release && bench/geometry/bin/geometry [--frames N] [--seed S] [--use-cache]
+//
+// The library is generated from scratch unless --use-cache is given, which
+// times loading it from the mesh cache instead.
+
+#define COUNT_ALLOCATIONS
+#include "AllocationCounter.h"
+#include "ofMain.h"
+#include "ofApp.h"
+
+#include <sys/resource.h>
+
+namespace {
+
+// Peak resident set size in MB
+double peakRssMb() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef TARGET_OSX
+    return usage.ru_maxrss / (1024.0 * 1024.0);
+#else
+    return usage.ru_maxrss / 1024.0;
+#endif
+}
+
+double millisSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// One frame of a seeded mix of drifting tones and noise, so the bands move
+// the way they do with music
+void synthesize(std::vector<float>& samples, int frame, std::mt19937& rng) {
+    std::uniform_real_distribution<float> noise(-0.1f, 0.1f);
+    size_t offset = frame * samples.size();
+    for (size_t i = 0; i < samples.size(); ++i) {
+        float t = static_cast<float>(offset + i) / FFT_SAMPLE_RATE;
+        float beat = 0.5f + 0.5f * std::sin(TWO_PI * 2.0f * t);
+        samples[i] = beat * std::sin(TWO_PI * 60.0f * t)
+                   + 0.5f * std::sin(TWO_PI * (440.0f + 200.0f * std::sin(t)) * t)
+                   + 0.25f * std::sin(TWO_PI * 3500.0f * t)
+                   + noise(rng);
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int frames = 200;
+    int seed = 1;
+    bool useCache = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--frames" && hasValue) {
+            frames = std::max(1, ofToInt(argv[++i]));
+        } else if (arg == "--seed" && hasValue) {
+            seed = ofToInt(argv[++i]);
+        } else if (arg == "--use-cache") {
+            useCache = true;
+        }
+    }
+    const int warmupFrames = 10;
+
+    ofInit();
+    ofSetLogLevel(OF_LOG_WARNING);
+
+    auto app = std::make_shared<ofApp>();
+    app->gpuDeform = false;
+    ofSeedRandom(seed);
+    std::mt19937 rng(seed);
+
+    auto start = std::chrono::steady_clock::now();
+    app->generateGeometries(useCache);
+    app->precomputedGeometries.freeze();
+    double libraryMs = millisSince(start);
+
+    // One frame's worth of samples at 30 fps
+    std::vector<float> samples(FFT_SAMPLE_RATE / 30);
+    app->analyzer.setup(FFT_WINDOW_SIZE, FFT_HOP_SIZE, FFT_BANDS, FFT_SAMPLE_RATE);
+    synthesize(samples, 0, rng);
+    app->analyzer.process(samples.data(), samples.size());
+    app->analyzer.update();
+
+    start = std::chrono::steady_clock::now();
+    Scene scene;
+    app->setupGeometry(scene, app->analyzer.getBands());
+    double sceneMs = millisSince(start);
+    app->applySceneGeometry(scene);
+
+    size_t vertices = 0;
+    for (auto& submesh : app->submeshes) {
+        vertices += submesh.positions.size();
+    }
+
+    std::vector<double> frameMs;
+    uint64_t frameAllocations = 0;
+    uint64_t frameBytes = 0;
+    for (int frame = 1; frame <= warmupFrames + frames; ++frame) {
+        synthesize(samples, frame, rng);
+        app->analyzer.process(samples.data(), samples.size());
+        app->analyzer.update();
+
+        uint64_t allocationsBefore = alloccount::allocations;
+        uint64_t bytesBefore = alloccount::bytes;
+        start = std::chrono::steady_clock::now();
+        app->rebuildGeometry();
+        double ms = millisSince(start);
+        if (frame > warmupFrames) {
+            frameMs.push_back(ms);
+            frameAllocations += alloccount::allocations - allocationsBefore;
+            frameBytes += alloccount::bytes - bytesBefore;
+        }
+    }
+    app->analyzer.stop();
+
+    // Changes whenever the output geometry does
+    double checksum = 0;
+    for (auto& vertex : app->shapeToRender->mesh.getVertices()) {
+        checksum += vertex.x + 2.0 * vertex.y + 3.0 * vertex.z;
+    }
+
+    std::sort(frameMs.begin(), frameMs.end());
+    double total = std::accumulate(frameMs.begin(), frameMs.end(), 0.0);
+    double mean = total / frameMs.size();
+    auto percentile = [&](double p) {
+        return frameMs[std::min(frameMs.size() - 1, static_cast<size_t>(p * frameMs.size()))];
+    };
+
+    printf("seed %d, %d frames after %d warm-up frames\n", seed, frames, warmupFrames);
+    printf("shape library       %zu shapes, %zu vertices, %.1f ms %s\n", app->precomputedGeometries.size(),
+           app->precomputedGeometries.numVertices(), libraryMs, useCache ? "(cached)" : "(generated)");
+    printf("setupGeometry       %zu submeshes, %zu vertices, %.1f ms\n", app->submeshes.size(), vertices, sceneMs);
+    printf("rebuild             mean %.3f ms, p50 %.3f ms, p95 %.3f ms\n", mean, percentile(0.5), percentile(0.95));
+    printf("                    %.2f ns/vertex\n", mean * 1e6 / std::max<size_t>(vertices, 1));
+    printf("                    %zu tasks on %zu threads\n", app->deformRanges.size(), app->threadPool.getNumWorkers() + 1);
+    printf("allocations         %.1f per frame, %.1f KB per frame\n", static_cast<double>(frameAllocations) / frames,
+           frameBytes / 1024.0 / frames);
+    printf("peak RSS            %.1f MB\n", peakRssMb());
+    printf("checksum            %.6e\n", checksum);
+    return 0;
+}
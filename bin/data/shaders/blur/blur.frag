@@ -0,0 +1,20 @@
+#version 150
+
+precision highp float;
+
+// One direction of a 9 tap Gaussian, in 5 bilinear fetches
+uniform sampler2D tex0;
+uniform vec2 texelStep; // one texel along the blur direction
+in vec2 vTexCoord;
+out vec4 fragColor;
+
+const float weights[3] = float[](0.2270270270, 0.3162162162, 0.0702702703);
+const float offsets[3] = float[](0.0, 1.3846153846, 3.2307692308);
+
+void main() {
+    fragColor = texture(tex0, vTexCoord) * weights[0];
+    for (int i = 1; i < 3; ++i) {
+        fragColor += texture(tex0, vTexCoord + texelStep * offsets[i]) * weights[i];
+        fragColor += texture(tex0, vTexCoord - texelStep * offsets[i]) * weights[i];
+    }
+}
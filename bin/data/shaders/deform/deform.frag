@@ -0,0 +1,23 @@
+#version 150
+
+precision highp float;
+
+uniform vec4 color;
+uniform vec3 lightPosition; // eye space
+
+in vec3 vPosition;
+in vec3 vNormal;
+out vec4 fragColor;
+
+void main() {
+    // Approximates the point light + shininess 128 material of the CPU path
+    vec3 n = normalize(vNormal);
+    vec3 l = normalize(lightPosition - vPosition);
+    vec3 v = normalize(-vPosition);
+    vec3 h = normalize(l + v);
+
+    float diffuse = abs(dot(n, l));
+    float specular = pow(max(dot(n, h), 0.0), 128.0);
+
+    fragColor = vec4(color.rgb * (0.2 + 0.8 * diffuse) + vec3(specular), color.a);
+}
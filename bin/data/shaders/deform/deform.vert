@@ -0,0 +1,43 @@
+#version 150
+
+precision highp float;
+
+uniform mat4 modelViewMatrix;
+uniform mat4 modelViewProjectionMatrix;
+
+uniform float spectrum[128]; // DeformShape::MAX_SPECTRUM_SIZE
+uniform int spectrumSize;
+uniform float audioScaling;
+uniform float vertexCount; // of the base mesh
+
+in vec4 position;
+in vec3 normal;
+in float vertexIndex;
+
+// per instance, what createPregeom baked into each copy
+in mat4 instanceTransform;
+in float instanceFileScale;
+
+out vec3 vPosition;
+out vec3 vNormal;
+
+void main() {
+    // Same bin lookup as ofApp::updatePregeom
+    float fftValue = 1.0;
+    if (spectrumSize > 0) {
+        int fftIndex = int(vertexIndex / vertexCount * float(spectrumSize - 1));
+        fftIndex = clamp(fftIndex, 0, spectrumSize - 1);
+        fftValue = spectrum[fftIndex] * audioScaling;
+    }
+
+    // The FFT scale is uniform, so applying it before the instance transform
+    // matches scaling the transformed copy on the CPU. Like postMult the
+    // transform's w row is ignored.
+    float scaleValue = instanceFileScale * (1.0 + fftValue * 0.1);
+    vec4 deformed = vec4((instanceTransform * vec4(position.xyz * scaleValue, 1.0)).xyz, 1.0);
+
+    // createPregeom leaves the normals of the copies untouched
+    vPosition = (modelViewMatrix * deformed).xyz;
+    vNormal = mat3(modelViewMatrix) * normal;
+    gl_Position = modelViewProjectionMatrix * deformed;
+}
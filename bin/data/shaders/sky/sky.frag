@@ -0,0 +1,11 @@
+#version 150
+
+precision highp float;
+
+uniform sampler2D skyTexture;
+in vec2 vTexCoord;
+out vec4 fragColor;
+
+void main() {
+    fragColor = texture(skyTexture, vTexCoord);
+}
@@ -0,0 +1,13 @@
+#version 150
+
+precision highp float;
+
+// Already in clip space, z = w puts the sky at the far plane
+in vec4 position;
+out vec2 vTexCoord;
+
+void main() {
+    // Image rows are top down
+    vTexCoord = vec2(position.x * 0.5 + 0.5, 0.5 - position.y * 0.5);
+    gl_Position = vec4(position.xy, 1.0, 1.0);
+}
@@ -5,11 +5,14 @@ precision highp float;
 uniform sampler2D waterTexture;
 uniform sampler2D reflectionTexture;
 in vec2 vTexCoord;
+in vec4 vReflectionPosition;
 out vec4 fragColor;
 
 void main() {
-    vec2 reflectTexCoords = vec2(vTexCoord.x, 1.0 - vTexCoord.y); 
+    // Where the mirrored scene was drawn for this point of the surface
+    vec2 reflectTexCoords = vReflectionPosition.xy / vReflectionPosition.w * 0.5 + 0.5;
     vec4 waterColor = texture(waterTexture, vTexCoord);
+    // The reflection is usually rendered smaller than the window, its linear filtering upsamples it
     vec4 reflectionColor = texture(reflectionTexture, reflectTexCoords);
     
     float reflectivity = 0.3;  // Adjust to control reflectivity
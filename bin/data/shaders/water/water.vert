@@ -3,11 +3,15 @@
 precision highp float;
 
 uniform mat4 modelViewProjectionMatrix;
+uniform mat4 modelViewMatrix;
+uniform mat4 reflectionMatrix; // eye space to the reflection pass's clip space
 in vec4 position;
 in vec2 texcoord;
 out vec2 vTexCoord;
+out vec4 vReflectionPosition;
 
 void main() {
     vTexCoord = texcoord;
+    vReflectionPosition = reflectionMatrix * modelViewMatrix * position;
     gl_Position = modelViewProjectionMatrix * position;
 }
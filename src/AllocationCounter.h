@@ -0,0 +1,63 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+// Counts general purpose heap allocations, for proving that a code path
+// doesn't allocate. The counting operator new is only compiled into the
+// translation unit that defines COUNT_ALLOCATIONS before including this
+// (main.cpp in DEBUG builds, bench/geometry), otherwise the counters stay 0.
+namespace alloccount {
+
+inline std::atomic<uint64_t> allocations{0};
+inline std::atomic<uint64_t> bytes{0};
+// The calling thread's share, not disturbed by the audio and loader threads
+inline thread_local uint64_t threadAllocations = 0;
+
+} // namespace alloccount
+
+#ifdef COUNT_ALLOCATIONS
+
+void* operator new(std::size_t size) {
+    alloccount::allocations++;
+    alloccount::threadAllocations++;
+    alloccount::bytes += size;
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    alloccount::allocations++;
+    alloccount::threadAllocations++;
+    alloccount::bytes += size;
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept {
+    return operator new(size, tag);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+#endif
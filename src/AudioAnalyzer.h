@@ -0,0 +1,215 @@
+#pragma once
+#include "ofMain.h"
+#include "FftBackend.h"
+#include "TripleBuffer.h"
+#include "Profiler.h"
+
+// Spectrum analysis of the live input on its own thread, a replacement for
+// ofxEasyFft::update() running on the render thread. audioIn() is called from
+// the sound stream callback and only copies samples into a lock-free ring.
+// The analysis thread keeps a sliding window of the last windowSize samples,
+// transforms it every hopSize new samples and publishes the result through a
+// triple buffer. The windowing and normalization are the same as ofxEasyFft,
+// the transform itself is the FftBackend picked at compile time.
+//
+// Besides the raw bins every analysis frame reduces the spectrum to a few
+// log-spaced bands, which is what the geometry looks up per vertex.
+//
+// The render thread calls update() once per frame and then reads getBins()
+// and getBands(), which stay the same until the next update().
+struct AudioSpectrum {
+    std::vector<float> bins;  // windowSize / 2 + 1, normalized to a peak of 1
+    std::vector<float> bands; // mean of the bins in each band
+};
+
+class AudioAnalyzer : public ofThread {
+public:
+    ~AudioAnalyzer() {
+        stop();
+    }
+
+    // Bands are spaced logarithmically from MIN_BAND_FREQUENCY to Nyquist
+    static constexpr float MIN_BAND_FREQUENCY = 30.0f;
+
+    void setup(int windowSize, int hopSize, int numBands, float sampleRate) {
+        fft = FftBackend::create(windowSize);
+        window.assign(windowSize, 0.0f);
+        signal.resize(windowSize);
+        hop = std::max(1, std::min(hopSize, windowSize));
+        setupBands(numBands, sampleRate);
+        ofLogNotice("AudioAnalyzer") << windowSize << " sample window (" << windowSize * 1000.0f / sampleRate << " ms), "
+                                     << hop << " sample hop (" << hop * 1000.0f / sampleRate << " ms), "
+                                     << numBands << " bands";
+
+        size_t ringSize = 1;
+        while (ringSize < static_cast<size_t>(windowSize) * 2) {
+            ringSize *= 2;
+        }
+        ring.assign(ringSize, 0.0f);
+        startThread();
+    }
+
+    // Sound stream thread, keeps the first channel
+    void audioIn(const ofSoundBuffer& input) {
+        if (ring.empty()) {
+            return;
+        }
+        size_t channels = input.getNumChannels();
+        size_t frames = input.getNumFrames();
+        size_t write = writePosition.load(std::memory_order_relaxed);
+        size_t read = readPosition.load(std::memory_order_acquire);
+        size_t mask = ring.size() - 1;
+
+        for (size_t i = 0; i < frames; ++i) {
+            if (write - read == ring.size()) {
+                // the analysis thread fell a whole ring behind, drop the rest
+                droppedSamples += frames - i;
+                break;
+            }
+            ring[write & mask] = input[i * channels];
+            write++;
+        }
+        writePosition.store(write, std::memory_order_release);
+    }
+
+    // Offline input: slides count new samples in and analyzes them right
+    // away on the calling thread, so the spectrum follows the caller's clock.
+    // Use instead of audioIn(), not together with it.
+    void process(const float* samples, size_t count) {
+        size_t size = window.size();
+        if (count < size) {
+            std::copy(window.begin() + count, window.end(), window.begin());
+            std::copy(samples, samples + count, window.end() - count);
+        } else {
+            std::copy(samples + count - size, samples + count, window.begin());
+        }
+        analyze();
+    }
+
+    // Render thread, takes the newest spectrum if there is one
+    void update() {
+        spectra.update();
+    }
+
+    const std::vector<float>& getBins() const {
+        return spectra.read().bins;
+    }
+
+    const std::vector<float>& getBands() const {
+        return spectra.read().bands;
+    }
+
+    uint64_t getDroppedSamples() const {
+        return droppedSamples;
+    }
+
+    void stop() {
+        stopThread();
+        waitForThread(false);
+    }
+
+protected:
+    void threadedFunction() override {
+        while (isThreadRunning()) {
+            if (!consume()) {
+                sleep(1);
+                continue;
+            }
+            analyze();
+        }
+    }
+
+private:
+    // Band b covers bins [bandEdges[b], bandEdges[b + 1]), at least one each
+    void setupBands(int numBands, float sampleRate) {
+        int numBins = fft->getBinSize();
+        float binWidth = sampleRate / window.size();
+        float ratio = std::pow(sampleRate / 2.0f / MIN_BAND_FREQUENCY, 1.0f / numBands);
+
+        bandEdges.resize(numBands + 1);
+        bandEdges[0] = std::max(1, static_cast<int>(MIN_BAND_FREQUENCY / binWidth));
+        for (int b = 1; b <= numBands; ++b) {
+            int edge = static_cast<int>(MIN_BAND_FREQUENCY * std::pow(ratio, b) / binWidth);
+            bandEdges[b] = std::min(std::max(edge, bandEdges[b - 1] + 1), numBins);
+        }
+        bandEdges[numBands] = numBins;
+    }
+
+    // Slides the window along by as many whole hops as have arrived. When the
+    // thread is behind the intermediate frames are skipped, only the newest
+    // window is analyzed.
+    bool consume() {
+        size_t read = readPosition.load(std::memory_order_relaxed);
+        size_t write = writePosition.load(std::memory_order_acquire);
+        size_t available = (write - read) / hop * hop;
+        if (available == 0) {
+            return false;
+        }
+        size_t end = read + available;
+
+        size_t size = window.size();
+        size_t mask = ring.size() - 1;
+        if (available < size) {
+            std::copy(window.begin() + available, window.end(), window.begin());
+        } else {
+            read += available - size;
+            available = size;
+        }
+        for (size_t i = 0; i < available; ++i) {
+            window[size - available + i] = ring[(read + i) & mask];
+        }
+        readPosition.store(end, std::memory_order_release);
+        return true;
+    }
+
+    void analyze() {
+        PROFILE_SCOPE("fft");
+        // ofxEasyFft normalizes the signal and the bins to a peak of 1
+        float peak = 0;
+        for (float sample : window) {
+            peak = std::max(peak, std::abs(sample));
+        }
+        float gain = peak > 0 ? 1.0f / peak : 0.0f;
+        for (size_t i = 0; i < window.size(); ++i) {
+            signal[i] = window[i] * gain;
+        }
+
+        AudioSpectrum& spectrum = spectra.write();
+        std::vector<float>& bins = spectrum.bins;
+        bins.resize(fft->getBinSize());
+        fft->amplitude(signal.data(), bins.data());
+
+        float maxBin = *std::max_element(bins.begin(), bins.end());
+        if (maxBin > 0) {
+            for (float& bin : bins) {
+                bin /= maxBin;
+            }
+        }
+
+        size_t numBands = bandEdges.size() - 1;
+        spectrum.bands.resize(numBands);
+        for (size_t b = 0; b < numBands; ++b) {
+            float sum = 0;
+            for (int i = bandEdges[b]; i < bandEdges[b + 1]; ++i) {
+                sum += bins[i];
+            }
+            spectrum.bands[b] = bandEdges[b + 1] > bandEdges[b] ? sum / (bandEdges[b + 1] - bandEdges[b]) : 0.0f;
+        }
+        spectra.publish();
+    }
+
+    std::unique_ptr<FftBackend> fft;
+    std::vector<float> window; // last windowSize samples, oldest first
+    std::vector<float> signal;
+    size_t hop = 1;
+    std::vector<int> bandEdges;
+
+    // audio callback -> analysis thread
+    std::vector<float> ring;
+    std::atomic<size_t> writePosition{0};
+    std::atomic<size_t> readPosition{0};
+    std::atomic<uint64_t> droppedSamples{0};
+
+    // analysis thread -> render thread
+    TripleBuffer<AudioSpectrum> spectra;
+};
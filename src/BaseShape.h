@@ -4,10 +4,11 @@
 class BaseShape {
 public:
     ofMesh mesh;
+    // Lights the whole shape, its diffuse and ambient come from color
     ofMaterial material;
-    ofVec3f position;
-    ofVec3f rotation;
-    ofVec3f scale;
+    ofFloatColor color = ofFloatColor::white;
+    // Per-vertex colors in mesh are only drawn when this is set
+    bool vertexColors = false;
 
     BaseShape() {
         scale.set(1.0f, 1.0f, 1.0f);
@@ -20,29 +21,99 @@ public:
     virtual void update() {}
 
     virtual void draw() {
-        ofMatrix4x4 transformMatrix;
-        transformMatrix.scale(scale);
-        transformMatrix.rotate(ofRadToDeg(rotation.x), 1, 0, 0);
-        transformMatrix.rotate(ofRadToDeg(rotation.y), 0, 1, 0);
-        transformMatrix.rotate(ofRadToDeg(rotation.z), 0, 0, 1);
-        transformMatrix.translate(position*2);
-        ofPushMatrix();
-        ofMultMatrix(transformMatrix);
+        BaseShape* self = this;
+        drawBatch(&self, 1);
+    }
+
+    // Draws the shape mirrored, e.g. by ReflectionPass::getMirrorMatrix()
+    void drawMirrored(const glm::mat4& mirror) {
+        BaseShape* self = this;
+        drawBatch(&self, 1, &mirror);
+    }
+
+    // Draws shapes with one matrix load each instead of a push, multiply and
+    // pop, optionally all mirrored by the same world space matrix
+    static void drawBatch(BaseShape* const* shapes, size_t count, const glm::mat4* mirror = nullptr) {
+        glm::mat4 modelView = ofGetCurrentMatrix(OF_MATRIX_MODELVIEW);
+        for (size_t i = 0; i < count; ++i) {
+            BaseShape& shape = *shapes[i];
+            ofLoadMatrix(modelView * (mirror ? shape.getMirroredModelMatrix(*mirror) : shape.getModelMatrix()));
+            shape.drawMesh();
+        }
+        ofLoadMatrix(modelView);
+    }
+
+    // Scale, then the rotations about x, y and z, then twice the translation.
+    // Only recomputed after the transform changed.
+    const glm::mat4& getModelMatrix() {
+        if (dirty) {
+            ofMatrix4x4 transformMatrix;
+            transformMatrix.scale(scale);
+            transformMatrix.rotate(ofRadToDeg(rotation.x), 1, 0, 0);
+            transformMatrix.rotate(ofRadToDeg(rotation.y), 0, 1, 0);
+            transformMatrix.rotate(ofRadToDeg(rotation.z), 0, 0, 1);
+            transformMatrix.translate(position * 2);
+            modelMatrix = glm::mat4(transformMatrix);
+            dirty = false;
+            mirroredDirty = true;
+        }
+        return modelMatrix;
+    }
+
+    const glm::mat4& getMirroredModelMatrix(const glm::mat4& mirror) {
+        const glm::mat4& model = getModelMatrix();
+        if (mirroredDirty || mirror != mirroredBy) {
+            mirroredModelMatrix = mirror * model;
+            mirroredBy = mirror;
+            mirroredDirty = false;
+        }
+        return mirroredModelMatrix;
+    }
 
+    // Called with the shape's transform applied
+    virtual void drawMesh() {
+        if (vertexColors) {
+            mesh.enableColors();
+        } else {
+            mesh.disableColors();
+        }
+        material.begin();
         mesh.draw();
+        material.end();
+    }
 
-        ofPopMatrix();
+    // One color for the whole shape, a uniform rather than a color per vertex
+    void setColor(const ofFloatColor& shapeColor) {
+        color = shapeColor;
+        material.setDiffuseColor(color);
+        material.setAmbientColor(color);
     }
 
     void applyScale(const ofVec3f& scaleVec) {
+        dirty |= scaleVec != scale;
         scale = scaleVec;
     }
 
     void applyRotation(const ofVec3f& rotationVec) {
+        dirty |= rotationVec != rotation;
         rotation = rotationVec;
     }
 
     void applyTranslation(const ofVec3f& translationVec) {
+        dirty |= translationVec != position;
         position = translationVec;
     }
+
+protected:
+    // Set through the apply functions, subclasses may set them in their constructor
+    ofVec3f position;
+    ofVec3f rotation;
+    ofVec3f scale;
+
+private:
+    bool dirty = true;
+    glm::mat4 modelMatrix;
+    bool mirroredDirty = true;
+    glm::mat4 mirroredModelMatrix;
+    glm::mat4 mirroredBy;
 };
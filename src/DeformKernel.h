@@ -0,0 +1,165 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+// FFT driven vertex deformation on structure-of-arrays position buffers.
+// This has no openFrameworks dependency so bench/ can build it on its own.
+namespace deform {
+
+// Destination of a deformation, three float arrays of at least the input's
+// size. Lets the output live in scratch memory rather than a Positions.
+struct Span {
+    float* x;
+    float* y;
+    float* z;
+};
+
+struct Positions {
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> z;
+
+    void resize(size_t n) {
+        x.resize(n);
+        y.resize(n);
+        z.resize(n);
+    }
+
+    size_t size() const {
+        return x.size();
+    }
+
+    Span span() {
+        return {x.data(), y.data(), z.data()};
+    }
+};
+
+struct Params {
+    const float* bins = nullptr;
+    int numBins = 0;
+    float fileScale = 1.0f;
+    float audioScaling = 1.0f;
+};
+
+// fileScale as computed from the submesh size in ofApp::createPregeom
+inline float fileScaleForSize(float size) {
+    return std::min(std::max(size / 300000.0f, 0.4f), 1.0f);
+}
+
+// Spectrum bin for vertex i of a submesh with count vertices, same as the
+// ofMap(i, 0, count, 0, numBins - 1, true) lookup in updatePregeom
+inline int binIndex(size_t i, size_t count, int numBins) {
+    int index = static_cast<int>(static_cast<float>(i) / static_cast<float>(count) * static_cast<float>(numBins - 1));
+    return std::min(std::max(index, 0), numBins - 1);
+}
+
+// The scale updatePregeom applies to vertex i. The translation it also
+// builds never reaches the vertex (ofMatrix4x4::postMult ignores the row it
+// lives in) so neither it nor its sin() offsets are evaluated here.
+inline float vertexScale(size_t i, size_t count, const Params& params) {
+    float fftValue = params.numBins == 0 ? 1.0f : params.bins[binIndex(i, count, params.numBins)] * params.audioScaling;
+    return params.fileScale * (1.0f + fftValue * 0.1f);
+}
+
+inline void scaleScalar(const Positions& in, Span out, const Params& params, size_t begin, size_t end) {
+    size_t count = in.size();
+    for (size_t i = begin; i < end; ++i) {
+        float s = vertexScale(i, count, params);
+        out.x[i] = in.x[i] * s;
+        out.y[i] = in.y[i] * s;
+        out.z[i] = in.z[i] * s;
+    }
+}
+
+#if defined(__AVX2__)
+
+inline void scaleSimd(const Positions& in, Span out, const Params& params, size_t begin, size_t end) {
+    if (params.numBins == 0) {
+        scaleScalar(in, out, params, begin, end);
+        return;
+    }
+
+    size_t count = in.size();
+    const __m256 countV = _mm256_set1_ps(static_cast<float>(count));
+    const __m256 maxBinF = _mm256_set1_ps(static_cast<float>(params.numBins - 1));
+    const __m256i maxBin = _mm256_set1_epi32(params.numBins - 1);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256 lane = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256 gain = _mm256_set1_ps(params.audioScaling * 0.1f);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 fileScale = _mm256_set1_ps(params.fileScale);
+
+    size_t i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256 index = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(i)), lane);
+        __m256i bin = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_div_ps(index, countV), maxBinF));
+        bin = _mm256_min_epi32(_mm256_max_epi32(bin, zero), maxBin);
+        __m256 fft = _mm256_i32gather_ps(params.bins, bin, 4);
+        __m256 s = _mm256_mul_ps(fileScale, _mm256_add_ps(one, _mm256_mul_ps(fft, gain)));
+
+        _mm256_storeu_ps(out.x + i, _mm256_mul_ps(_mm256_loadu_ps(&in.x[i]), s));
+        _mm256_storeu_ps(out.y + i, _mm256_mul_ps(_mm256_loadu_ps(&in.y[i]), s));
+        _mm256_storeu_ps(out.z + i, _mm256_mul_ps(_mm256_loadu_ps(&in.z[i]), s));
+    }
+    scaleScalar(in, out, params, i, end);
+}
+
+#elif defined(__SSE2__) || defined(_M_X64)
+
+inline void scaleSimd(const Positions& in, Span out, const Params& params, size_t begin, size_t end) {
+    if (params.numBins == 0) {
+        scaleScalar(in, out, params, begin, end);
+        return;
+    }
+
+    size_t count = in.size();
+    const __m128 countV = _mm_set1_ps(static_cast<float>(count));
+    const __m128 maxBinF = _mm_set1_ps(static_cast<float>(params.numBins - 1));
+    const __m128 lane = _mm_setr_ps(0, 1, 2, 3);
+    const __m128 gain = _mm_set1_ps(params.audioScaling * 0.1f);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 fileScale = _mm_set1_ps(params.fileScale);
+    const int maxBin = params.numBins - 1;
+
+    alignas(16) int bin[4];
+    size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m128 index = _mm_add_ps(_mm_set1_ps(static_cast<float>(i)), lane);
+        _mm_store_si128(reinterpret_cast<__m128i*>(bin), _mm_cvttps_epi32(_mm_mul_ps(_mm_div_ps(index, countV), maxBinF)));
+
+        // SSE2 has no gather, the lookups stay scalar
+        __m128 fft = _mm_setr_ps(params.bins[std::min(std::max(bin[0], 0), maxBin)],
+                                 params.bins[std::min(std::max(bin[1], 0), maxBin)],
+                                 params.bins[std::min(std::max(bin[2], 0), maxBin)],
+                                 params.bins[std::min(std::max(bin[3], 0), maxBin)]);
+        __m128 s = _mm_mul_ps(fileScale, _mm_add_ps(one, _mm_mul_ps(fft, gain)));
+
+        _mm_storeu_ps(out.x + i, _mm_mul_ps(_mm_loadu_ps(&in.x[i]), s));
+        _mm_storeu_ps(out.y + i, _mm_mul_ps(_mm_loadu_ps(&in.y[i]), s));
+        _mm_storeu_ps(out.z + i, _mm_mul_ps(_mm_loadu_ps(&in.z[i]), s));
+    }
+    scaleScalar(in, out, params, i, end);
+}
+
+#else
+
+inline void scaleSimd(const Positions& in, Span out, const Params& params, size_t begin, size_t end) {
+    scaleScalar(in, out, params, begin, end);
+}
+
+#endif
+
+// Deforms every vertex of in into out, which must have room for in.size() vertices
+inline void scale(const Positions& in, Span out, const Params& params) {
+    scaleSimd(in, out, params, 0, in.size());
+}
+
+} // namespace deform
@@ -0,0 +1,141 @@
+#pragma once
+#include "BaseShape.h"
+#include "MeshOptimize.h"
+
+// GPU copy of one library shape. It is uploaded once and shared by every
+// batch that draws the shape, across regenerations.
+struct GpuMesh {
+    ofBufferObject vertices;
+    ofBufferObject normals;
+    ofBufferObject indices;
+    ofBufferObject vertexIndices; // 0..n-1 as floats, for the FFT bin lookup
+    int numVertices = 0;
+    int numIndices = 0;
+    bool hasNormals = false;
+    GLenum mode = GL_TRIANGLES;
+    GLenum indexType = GL_UNSIGNED_INT; // GL_UNSIGNED_SHORT when the vertices fit
+
+    void setup(const ofMesh& mesh) {
+        numVertices = mesh.getNumVertices();
+        numIndices = mesh.getNumIndices();
+        mode = ofGetGLPrimitiveMode(mesh.getMode());
+
+        vertices.allocate(mesh.getVertices(), GL_STATIC_DRAW);
+        hasNormals = mesh.getNumNormals() == mesh.getNumVertices();
+        if (hasNormals) {
+            normals.allocate(mesh.getNormals(), GL_STATIC_DRAW);
+        }
+        if (numIndices > 0 && meshopt::fitsShortIndices(mesh)) {
+            std::vector<uint16_t> shortIndices(mesh.getIndices().begin(), mesh.getIndices().end());
+            indices.allocate(shortIndices, GL_STATIC_DRAW);
+            indexType = GL_UNSIGNED_SHORT;
+        } else if (numIndices > 0) {
+            indices.allocate(mesh.getIndices(), GL_STATIC_DRAW);
+        }
+
+        std::vector<float> index(numVertices);
+        for (int i = 0; i < numVertices; ++i) {
+            index[i] = i;
+        }
+        vertexIndices.allocate(index, GL_STATIC_DRAW);
+    }
+};
+
+// The scene drawn with instancing: one batch per distinct library shape, each
+// drawing the shape's GpuMesh once per createPregeom copy. The per-frame
+// FFT driven scale from ofApp::updatePregeom is applied in
+// shaders/deform/deform.vert, which gets the band spectrum as a uniform
+// array, so nothing is rebuilt or re-uploaded on the CPU.
+class DeformShape : public BaseShape {
+public:
+    static const int INDEX_ATTRIBUTE = 4;
+    static const int MATRIX_ATTRIBUTE = 5; // a mat4 takes locations 5-8
+    static const int FILE_SCALE_ATTRIBUTE = 9;
+    // Size of the spectrum uniform array in deform.vert
+    static const int MAX_SPECTRUM_SIZE = 128;
+
+    // Per-instance data, the transform createPregeom baked into each copy
+    struct Instance {
+        glm::mat4 transform;
+        float fileScale;
+    };
+
+    ofShader* shader = nullptr;
+    const std::vector<float>* spectrum = nullptr;
+    float audioScaling = 1.0f;
+    glm::vec3 lightPosition; // eye space
+
+    static bool loadShader(ofShader& deformShader) {
+        deformShader.setupShaderFromFile(GL_VERTEX_SHADER, "shaders/deform/deform.vert");
+        deformShader.setupShaderFromFile(GL_FRAGMENT_SHADER, "shaders/deform/deform.frag");
+        deformShader.bindDefaults();
+        deformShader.bindAttribute(INDEX_ATTRIBUTE, "vertexIndex");
+        deformShader.bindAttribute(MATRIX_ATTRIBUTE, "instanceTransform");
+        deformShader.bindAttribute(FILE_SCALE_ATTRIBUTE, "instanceFileScale");
+        return deformShader.linkProgram();
+    }
+
+    void addBatch(const std::shared_ptr<GpuMesh>& mesh, const std::vector<Instance>& instances) {
+        batches.emplace_back();
+        Batch& batch = batches.back();
+        batch.mesh = mesh;
+        batch.numInstances = instances.size();
+        batch.instances.allocate(instances, GL_STATIC_DRAW);
+
+        batch.vbo.setVertexBuffer(mesh->vertices, 3, sizeof(glm::vec3));
+        if (mesh->hasNormals) {
+            batch.vbo.setNormalBuffer(mesh->normals, sizeof(glm::vec3));
+        }
+        if (mesh->numIndices > 0) {
+            batch.vbo.setIndexBuffer(mesh->indices);
+        }
+        batch.vbo.setAttributeBuffer(INDEX_ATTRIBUTE, mesh->vertexIndices, 1, sizeof(float));
+        for (int column = 0; column < 4; ++column) {
+            batch.vbo.setAttributeBuffer(MATRIX_ATTRIBUTE + column, batch.instances, 4, sizeof(Instance),
+                                         offsetof(Instance, transform) + column * sizeof(glm::vec4));
+            batch.vbo.setAttributeDivisor(MATRIX_ATTRIBUTE + column, 1);
+        }
+        batch.vbo.setAttributeBuffer(FILE_SCALE_ATTRIBUTE, batch.instances, 1, sizeof(Instance), offsetof(Instance, fileScale));
+        batch.vbo.setAttributeDivisor(FILE_SCALE_ATTRIBUTE, 1);
+    }
+
+    void drawMesh() override {
+        if (shader == nullptr || spectrum == nullptr) {
+            return;
+        }
+
+        int spectrumSize = std::min<int>(spectrum->size(), MAX_SPECTRUM_SIZE);
+        shader->begin();
+        if (spectrumSize > 0) {
+            shader->setUniform1fv("spectrum", spectrum->data(), spectrumSize);
+        }
+        shader->setUniform1i("spectrumSize", spectrumSize);
+        shader->setUniform1f("audioScaling", audioScaling);
+        shader->setUniform4f("color", color);
+        shader->setUniform3f("lightPosition", lightPosition);
+
+        for (auto& batch : batches) {
+            shader->setUniform1f("vertexCount", batch.mesh->numVertices);
+            if (batch.mesh->numIndices > 0) {
+                // ofVbo::drawElementsInstanced() only knows 32 bit indices
+                batch.vbo.bind();
+                glDrawElementsInstanced(batch.mesh->mode, batch.mesh->numIndices, batch.mesh->indexType, nullptr, batch.numInstances);
+                batch.vbo.unbind();
+            } else {
+                batch.vbo.drawInstanced(batch.mesh->mode, 0, batch.mesh->numVertices, batch.numInstances);
+            }
+        }
+
+        shader->end();
+    }
+
+private:
+    struct Batch {
+        std::shared_ptr<GpuMesh> mesh;
+        ofBufferObject instances;
+        ofVbo vbo;
+        int numInstances = 0;
+    };
+
+    std::vector<Batch> batches;
+};
@@ -0,0 +1,86 @@
+#pragma once
+#include "ofMain.h"
+#include "ofxFft.h"
+#include "RealFft.h"
+
+// Windowed magnitude spectrum of a block of real samples, the part of ofxFft
+// AudioAnalyzer uses. The backend is picked at compile time: realfft::Plan
+// (RealFft.h) by default, or ofxFft with FFT_BACKEND_OFXFFT defined (see
+// PROJECT_DEFINES in config.make). bench/fft_bench compares them.
+class FftBackend {
+public:
+    virtual ~FftBackend() {}
+
+    int getSignalSize() const {
+        return signalSize;
+    }
+
+    int getBinSize() const {
+        return signalSize / 2 + 1;
+    }
+
+    // Hamming windowed amplitudes of getSignalSize() samples into getBinSize() floats
+    virtual void amplitude(const float* signal, float* out) = 0;
+
+    static std::unique_ptr<FftBackend> create(int signalSize);
+
+protected:
+    int signalSize = 0;
+};
+
+class OfxFftBackend : public FftBackend {
+public:
+    explicit OfxFftBackend(int size) : fft(ofxFft::create(size, OF_FFT_WINDOW_HAMMING)) {
+        signalSize = size;
+    }
+
+    void amplitude(const float* signal, float* out) override {
+        fft->setSignal(signal);
+        const float* amplitude = fft->getAmplitude();
+        std::copy(amplitude, amplitude + getBinSize(), out);
+    }
+
+private:
+    std::unique_ptr<ofxFft> fft;
+};
+
+class RealFftBackend : public FftBackend {
+public:
+    explicit RealFftBackend(int size) : plan(size), windowed(size), re(size / 2 + 1), im(size / 2 + 1) {
+        signalSize = size;
+        // same Hamming window as ofxFft
+        window.resize(size);
+        for (int i = 0; i < size; ++i) {
+            window[i] = 0.54f - 0.46f * cos(TWO_PI * i / (size - 1));
+        }
+    }
+
+    void amplitude(const float* signal, float* out) override {
+        for (int i = 0; i < signalSize; ++i) {
+            windowed[i] = signal[i] * window[i];
+        }
+        plan.forward(windowed.data(), re.data(), im.data());
+        for (int k = 0; k < getBinSize(); ++k) {
+            out[k] = sqrt(re[k] * re[k] + im[k] * im[k]);
+        }
+    }
+
+private:
+    realfft::Plan plan;
+    std::vector<float> window;
+    std::vector<float> windowed;
+    std::vector<float> re;
+    std::vector<float> im;
+};
+
+inline std::unique_ptr<FftBackend> FftBackend::create(int signalSize) {
+#ifdef FFT_BACKEND_OFXFFT
+    return std::make_unique<OfxFftBackend>(signalSize);
+#else
+    if (signalSize < 16 || (signalSize & (signalSize - 1)) != 0) {
+        ofLogWarning("FftBackend") << signalSize << " is not a power of two of at least 16, using ofxFft";
+        return std::make_unique<OfxFftBackend>(signalSize);
+    }
+    return std::make_unique<RealFftBackend>(signalSize);
+#endif
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// Linear allocator for scratch memory that only lives for one frame.
+// allocate() bumps a pointer into one block and reset() at the start of the
+// next frame hands all of it out again, nothing is freed individually. A
+// frame that needs more than the block gets the rest from the heap, and the
+// next reset() grows the block to that frame's high-water mark, so once the
+// frames stop growing no heap allocations happen at all.
+class FrameArena {
+public:
+    explicit FrameArena(size_t initialCapacity = 0) {
+        grow(initialCapacity);
+    }
+
+    // Uninitialized storage for count Ts, valid until the next reset()
+    template<typename T>
+    T* allocate(size_t count) {
+        static_assert(std::is_trivially_destructible<T>::value, "arena memory is never destructed");
+        return static_cast<T*>(allocateBytes(count * sizeof(T), std::max<size_t>(alignof(T), ALIGNMENT)));
+    }
+
+    void reset() {
+        size_t needed = offset + overflowBytes;
+        if (needed > capacity) {
+            overflow.clear();
+            grow(needed + needed / 2);
+        }
+        highWater = std::max(highWater, needed);
+        offset = 0;
+        overflowBytes = 0;
+    }
+
+    size_t getCapacity() const {
+        return capacity;
+    }
+
+    size_t getHighWater() const {
+        return highWater;
+    }
+
+    // Heap allocations made because the block was too small, including growing it
+    uint64_t getHeapAllocations() const {
+        return heapAllocations;
+    }
+
+private:
+    // Cache line aligned, so SIMD loads and stores never split a line
+    static const size_t ALIGNMENT = 64;
+
+    void* allocateBytes(size_t bytes, size_t alignment) {
+        size_t start = (offset + alignment - 1) / alignment * alignment;
+        if (start + bytes <= capacity) {
+            offset = start + bytes;
+            return block + start;
+        }
+        overflow.emplace_back(new unsigned char[bytes + alignment]);
+        overflowBytes += bytes + alignment;
+        heapAllocations++;
+        uintptr_t address = reinterpret_cast<uintptr_t>(overflow.back().get());
+        return reinterpret_cast<void*>((address + alignment - 1) / alignment * alignment);
+    }
+
+    void grow(size_t bytes) {
+        // over-allocate so the start of the block can be aligned
+        storage.reset(bytes > 0 ? new unsigned char[bytes + ALIGNMENT] : nullptr);
+        uintptr_t address = reinterpret_cast<uintptr_t>(storage.get());
+        block = reinterpret_cast<unsigned char*>((address + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT);
+        capacity = bytes;
+        if (bytes > 0) {
+            heapAllocations++;
+        }
+    }
+
+    std::unique_ptr<unsigned char[]> storage;
+    unsigned char* block = nullptr; // storage, aligned
+    size_t capacity = 0;
+    size_t offset = 0;
+    size_t highWater = 0;
+
+    std::vector<std::unique_ptr<unsigned char[]>> overflow;
+    size_t overflowBytes = 0;
+    uint64_t heapAllocations = 0;
+};
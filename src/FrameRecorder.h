@@ -0,0 +1,162 @@
+#pragma once
+#include "ofMain.h"
+
+// Writes rendered frames to disk without stalling the render thread.
+// capture() only queues a copy of the FBO into one of a ring of pixel buffer
+// objects. The copy is read back a few frames later, when its fence has long
+// signaled, and handed to encoder threads that flip it and write either
+// numbered PNGs or one raw RGBA stream. The render thread blocks only when
+// the GPU is a whole ring behind or every spare frame is waiting for the
+// encoders.
+class FrameRecorder {
+public:
+    enum Format {
+        Png,    // <dir>/frame_000000.png ...
+        RawRgba // <dir>/frames.rgba, frames back to back, top row first
+    };
+
+    ~FrameRecorder() {
+        finish();
+    }
+
+    void setup(int frameWidth, int frameHeight, const std::string& dir, Format outputFormat, int numPbos = 3) {
+        width = frameWidth;
+        height = frameHeight;
+        directory = dir;
+        format = outputFormat;
+        ofDirectory::createDirectory(directory, true, true);
+
+        slots.resize(numPbos);
+        for (auto& slot : slots) {
+            slot.pbo.allocate(width * height * 4, GL_STREAM_READ);
+        }
+
+        // Raw frames go to one stream in order, PNGs can be encoded in parallel
+        int numEncoders = format == RawRgba ? 1 : std::max(1u, std::thread::hardware_concurrency() / 2);
+        for (int i = 0; i < numEncoders * 2 + 2; ++i) {
+            ofPixels pixels;
+            pixels.allocate(width, height, OF_PIXELS_RGBA);
+            freePixels.send(std::move(pixels));
+        }
+        if (format == RawRgba) {
+            raw.open(ofToDataPath(directory + "/frames.rgba", true), std::ios::binary);
+        }
+        for (int i = 0; i < numEncoders; ++i) {
+            encoders.push_back(std::make_unique<Encoder>(*this));
+            encoders.back()->startThread();
+        }
+    }
+
+    // Render thread, queues the readback of the fbo's color attachment
+    void capture(const ofFbo& fbo) {
+        Slot& slot = slots[next];
+        if (slot.frame >= 0) {
+            retire(slot);
+        }
+        fbo.getTexture().copyTo(slot.pbo);
+        slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        slot.frame = captured++;
+        next = (next + 1) % slots.size();
+    }
+
+    // Render thread, reads back what is still in flight and waits for the encoders
+    void finish() {
+        if (encoders.empty()) {
+            return;
+        }
+        for (size_t i = 0; i < slots.size(); ++i) {
+            Slot& slot = slots[(next + i) % slots.size()];
+            if (slot.frame >= 0) {
+                retire(slot);
+            }
+        }
+        while (written < captured) {
+            ofSleepMillis(1);
+        }
+        toEncode.close();
+        freePixels.close();
+        for (auto& encoder : encoders) {
+            encoder->waitForThread(false);
+        }
+        encoders.clear();
+        raw.close();
+        ofLogNotice("FrameRecorder") << written << " frames written to " << directory;
+    }
+
+    int getFramesWritten() const {
+        return written;
+    }
+
+private:
+    struct Slot {
+        ofBufferObject pbo;
+        GLsync fence = nullptr;
+        int frame = -1;
+    };
+
+    struct Frame {
+        int index;
+        ofPixels pixels;
+    };
+
+    class Encoder : public ofThread {
+    public:
+        explicit Encoder(FrameRecorder& owner) : recorder(owner) {}
+
+    protected:
+        void threadedFunction() override {
+            Frame frame;
+            while (recorder.toEncode.receive(frame)) {
+                recorder.write(frame);
+                recorder.freePixels.send(std::move(frame.pixels));
+                recorder.written++;
+            }
+        }
+
+    private:
+        FrameRecorder& recorder;
+    };
+
+    void retire(Slot& slot) {
+        // Normally signaled already, the copy was queued slots.size() frames ago
+        glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+
+        Frame frame;
+        frame.index = slot.frame;
+        freePixels.receive(frame.pixels);
+        const unsigned char* data = slot.pbo.map<unsigned char>(GL_READ_ONLY);
+        memcpy(frame.pixels.getData(), data, frame.pixels.getTotalBytes());
+        slot.pbo.unmap();
+        slot.frame = -1;
+        toEncode.send(std::move(frame));
+    }
+
+    // Encoder threads, GL rows are bottom up
+    void write(Frame& frame) {
+        frame.pixels.mirror(true, false);
+        if (format == RawRgba) {
+            raw.write(reinterpret_cast<const char*>(frame.pixels.getData()), frame.pixels.getTotalBytes());
+        } else {
+            ofPixels rgb = frame.pixels;
+            rgb.setNumChannels(3);
+            ofSaveImage(rgb, directory + "/frame_" + ofToString(frame.index, 6, '0') + ".png");
+        }
+    }
+
+    int width = 0;
+    int height = 0;
+    std::string directory;
+    Format format = Png;
+
+    std::vector<Slot> slots;
+    size_t next = 0;
+    int captured = 0;
+    std::atomic<int> written{0};
+
+    ofThreadChannel<Frame> toEncode;
+    ofThreadChannel<ofPixels> freePixels;
+    std::vector<std::unique_ptr<Encoder>> encoders;
+    std::ofstream raw;
+};
@@ -1,5 +1,6 @@
 #pragma once
 #include "BaseShape.h"
+#include "TubeMesh.h"
 
 class Leg : public BaseShape {
 public:
@@ -14,8 +15,8 @@ public:
                 randomPoints.addVertex(-30 * i, -40 * sin(i * 2), 0);
             }
 
-            // Generate the tube mesh from the polyline
-            ofMesh geometry = generateTubeMesh(randomPoints, radius, 7);
+            // Both halves share the same tube, it is only generated once
+            ofMesh geometry = *tube::sweep(randomPoints, radius, 7);
 
             // Apply rotation
             float rotationAngle = sin(j);
@@ -40,48 +41,4 @@ public:
         // Set the generated geometry as the mesh of the BaseShape
         mesh = tentacleGeom;
     }
-
-private:
-    ofMesh generateTubeMesh(const ofPolyline& line, float radius, int segments) {
-        ofMesh mesh;
-        mesh.setMode(OF_PRIMITIVE_TRIANGLES);
-
-        for (int i = 0; i < line.size(); i++) {
-            ofVec3f thisPoint = line[i];
-            ofVec3f nextPoint = line[(i + 1) % line.size()];  // next point in the polyline
-
-            ofVec3f direction = (nextPoint - thisPoint).normalized();
-            ofVec3f normal = direction.getCrossed(ofVec3f(0, 0, 1)).normalize();  // create a perpendicular vector
-            ofVec3f binormal = direction.getCrossed(normal).normalize();  // another perpendicular vector
-
-            for (int j = 0; j < segments; j++) {
-                float theta = ofMap(j, 0, segments, 0, TWO_PI);
-                ofVec3f offset = radius * (cos(theta) * normal + sin(theta) * binormal);
-                mesh.addVertex(thisPoint + offset);  // add the vertex to the mesh
-                mesh.addNormal(offset.normalized());  // add the normal for shading
-                mesh.addTexCoord(ofVec2f(j / (float)segments, i / (float)line.size()));  // optional: add texture coordinates
-            }
-        }
-
-        // Create the faces of the tube
-        for (int i = 0; i < line.size() - 1; i++) {
-            for (int j = 0; j < segments; j++) {
-                int nextSegment = (j + 1) % segments;
-                int currentIndex = i * segments + j;
-                int nextIndex = (i + 1) * segments + j;
-                int nextSegmentIndex = i * segments + nextSegment;
-                int nextIndexSegment = (i + 1) * segments + nextSegment;
-
-                mesh.addIndex(currentIndex);
-                mesh.addIndex(nextIndex);
-                mesh.addIndex(nextIndexSegment);
-
-                mesh.addIndex(currentIndex);
-                mesh.addIndex(nextIndexSegment);
-                mesh.addIndex(nextSegmentIndex);
-            }
-        }
-
-        return mesh;
-    }
 };
@@ -0,0 +1,317 @@
+#pragma once
+#include "ofMain.h"
+
+// Post-processing for generated triangle meshes. Composite shapes (Minerals,
+// Leg) are built by appending transformed copies, and tube sweeps and the
+// create*Mesh functions emit vertices per face, so meshes come out with
+// duplicated vertices, zero area triangles and an index order that thrashes
+// the post-transform cache. optimize() welds identical vertices, drops
+// degenerate triangles, reorders the triangles for the vertex cache (Forsyth,
+// "Linear-Speed Vertex Cache Optimisation") and the vertices in the order the
+// triangles first use them. Fewer vertices means less to deform on the CPU
+// path and less to upload; the order helps both the GPU and the deform loop.
+//
+//   meshopt::Stats stats = meshopt::optimize(shape->mesh);
+namespace meshopt {
+
+// Simulated FIFO post-transform cache size, 32 is typical of current GPUs
+const int CACHE_SIZE = 32;
+
+struct Stats {
+    size_t verticesBefore = 0;
+    size_t indicesBefore = 0;
+    size_t verticesAfter = 0;
+    size_t indicesAfter = 0;
+    size_t cacheMissesBefore = 0; // see cacheMisses()
+    size_t cacheMissesAfter = 0;
+
+    Stats& operator+=(const Stats& other) {
+        verticesBefore += other.verticesBefore;
+        indicesBefore += other.indicesBefore;
+        verticesAfter += other.verticesAfter;
+        indicesAfter += other.indicesAfter;
+        cacheMissesBefore += other.cacheMissesBefore;
+        cacheMissesAfter += other.cacheMissesAfter;
+        return *this;
+    }
+};
+
+// Vertices a FIFO cache of CACHE_SIZE has to transform to draw indices. Per
+// triangle this is between 0.5 for an ideal order and 3 for no reuse at all.
+inline size_t cacheMisses(const std::vector<ofIndexType>& indices, size_t numVertices) {
+    std::vector<size_t> insertedAt(numVertices, 0);
+    size_t time = 0; // FIFO insertions so far, entries older than CACHE_SIZE are gone
+    size_t misses = 0;
+    for (ofIndexType index : indices) {
+        if (insertedAt[index] == 0 || time - insertedAt[index] >= CACHE_SIZE) {
+            insertedAt[index] = ++time;
+            misses++;
+        }
+    }
+    return misses;
+}
+
+// Maps every vertex to the first one with bit identical attributes, returns
+// the number of distinct vertices. -0 and 0 compare equal.
+inline size_t weld(const ofMesh& mesh, std::vector<ofIndexType>& remap) {
+    size_t numVertices = mesh.getNumVertices();
+    bool hasNormals = mesh.getNumNormals() == numVertices;
+    bool hasTexCoords = mesh.getNumTexCoords() == numVertices;
+    bool hasColors = mesh.getNumColors() == numVertices;
+    size_t stride = 3 + (hasNormals ? 3 : 0) + (hasTexCoords ? 2 : 0) + (hasColors ? 4 : 0);
+
+    std::vector<uint32_t> keys(numVertices * stride);
+    auto store = [](uint32_t* key, const float* values, size_t count) {
+        for (size_t c = 0; c < count; ++c) {
+            float value = values[c] + 0.0f; // -0 becomes 0
+            std::memcpy(key + c, &value, sizeof(float));
+        }
+        return key + count;
+    };
+    for (size_t v = 0; v < numVertices; ++v) {
+        uint32_t* key = &keys[v * stride];
+        key = store(key, &mesh.getVertices()[v].x, 3);
+        if (hasNormals) {
+            key = store(key, &mesh.getNormals()[v].x, 3);
+        }
+        if (hasTexCoords) {
+            key = store(key, &mesh.getTexCoords()[v].x, 2);
+        }
+        if (hasColors) {
+            store(key, &mesh.getColors()[v].r, 4);
+        }
+    }
+
+    // Sorting instead of hashing keeps the result independent of the platform
+    std::vector<ofIndexType> order(numVertices);
+    std::iota(order.begin(), order.end(), 0);
+    auto compare = [&](ofIndexType a, ofIndexType b) {
+        int byKey = std::memcmp(&keys[a * stride], &keys[b * stride], stride * sizeof(uint32_t));
+        return byKey != 0 ? byKey < 0 : a < b;
+    };
+    std::sort(order.begin(), order.end(), compare);
+
+    remap.resize(numVertices);
+    size_t unique = 0;
+    for (size_t i = 0; i < numVertices; ++i) {
+        ofIndexType v = order[i];
+        if (i > 0 && std::memcmp(&keys[v * stride], &keys[order[i - 1] * stride], stride * sizeof(uint32_t)) == 0) {
+            remap[v] = remap[order[i - 1]];
+        } else {
+            remap[v] = v; // the lowest index of its group, sorted first
+            unique++;
+        }
+    }
+    return unique;
+}
+
+// Whether the triangle has no area: coincident corners, or collinear ones up
+// to float precision. The angle at a has a squared sine of |u x v|^2 / (|u|^2 |v|^2),
+// below 1e-10 (about 0.0006 degrees) the triangle is treated as a line.
+inline bool isDegenerate(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) {
+    glm::vec3 u = b - a;
+    glm::vec3 v = c - a;
+    glm::vec3 normal = glm::cross(u, v);
+    return glm::dot(normal, normal) <= 1e-10f * glm::dot(u, u) * glm::dot(v, v);
+}
+
+// Forsyth's vertex cache optimisation: greedily emits the triangle whose
+// vertices score highest, where a vertex scores for being recently used and
+// for having few triangles left, so fans are finished before moving on.
+inline void reorderForCache(std::vector<ofIndexType>& indices, size_t numVertices) {
+    const float CACHE_DECAY_POWER = 1.5f;
+    const float LAST_TRIANGLE_SCORE = 0.75f;
+    const float VALENCE_BOOST_SCALE = 2.0f;
+    const float VALENCE_BOOST_POWER = 0.5f;
+
+    size_t numTriangles = indices.size() / 3;
+    if (numTriangles < 2) {
+        return;
+    }
+
+    // Triangles of every vertex, the first `remaining` of a vertex's slice are not emitted yet
+    std::vector<uint32_t> firstTriangle(numVertices + 1, 0);
+    for (ofIndexType index : indices) {
+        firstTriangle[index + 1]++;
+    }
+    for (size_t v = 0; v < numVertices; ++v) {
+        firstTriangle[v + 1] += firstTriangle[v];
+    }
+    std::vector<uint32_t> remaining(numVertices, 0);
+    std::vector<uint32_t> vertexTriangles(indices.size());
+    for (size_t t = 0; t < numTriangles; ++t) {
+        for (int corner = 0; corner < 3; ++corner) {
+            ofIndexType v = indices[t * 3 + corner];
+            vertexTriangles[firstTriangle[v] + remaining[v]++] = t;
+        }
+    }
+
+    std::vector<int> cachePosition(numVertices, -1);
+    auto vertexScore = [&](ofIndexType v) {
+        if (remaining[v] == 0) {
+            return -1.0f;
+        }
+        float score = 0;
+        int position = cachePosition[v];
+        if (position >= 0) {
+            if (position < 3) {
+                // Used by the last triangle, a fixed score so it isn't simply repeated
+                score = LAST_TRIANGLE_SCORE;
+            } else {
+                score = std::pow(1.0f - (position - 3) / static_cast<float>(CACHE_SIZE - 3), CACHE_DECAY_POWER);
+            }
+        }
+        return score + VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remaining[v]), -VALENCE_BOOST_POWER);
+    };
+
+    std::vector<float> scores(numVertices);
+    for (size_t v = 0; v < numVertices; ++v) {
+        scores[v] = vertexScore(v);
+    }
+
+    std::vector<bool> emitted(numTriangles, false);
+    std::vector<ofIndexType> reordered;
+    reordered.reserve(indices.size());
+    std::vector<ofIndexType> cache, nextCache;
+    cache.reserve(CACHE_SIZE + 3);
+    nextCache.reserve(CACHE_SIZE + 3);
+    size_t scanFrom = 0; // every triangle before this one is emitted
+    int best = -1;
+
+    for (size_t emittedCount = 0; emittedCount < numTriangles; ++emittedCount) {
+        if (best < 0) {
+            // Nothing left next to the cache, continue with the first unemitted triangle
+            while (emitted[scanFrom]) {
+                scanFrom++;
+            }
+            best = scanFrom;
+        }
+
+        emitted[best] = true;
+        nextCache.clear();
+        for (int corner = 0; corner < 3; ++corner) {
+            ofIndexType v = indices[best * 3 + corner];
+            reordered.push_back(v);
+            nextCache.push_back(v);
+            // Remove the triangle from the vertex's pending ones
+            uint32_t* triangles = &vertexTriangles[firstTriangle[v]];
+            for (uint32_t i = 0; i < remaining[v]; ++i) {
+                if (triangles[i] == static_cast<uint32_t>(best)) {
+                    std::swap(triangles[i], triangles[--remaining[v]]);
+                    break;
+                }
+            }
+        }
+        for (ofIndexType v : cache) {
+            if (std::find(nextCache.begin(), nextCache.end(), v) == nextCache.end()) {
+                nextCache.push_back(v);
+            }
+        }
+        for (size_t i = CACHE_SIZE; i < nextCache.size(); ++i) {
+            cachePosition[nextCache[i]] = -1;
+            scores[nextCache[i]] = vertexScore(nextCache[i]);
+        }
+        nextCache.resize(std::min<size_t>(nextCache.size(), CACHE_SIZE));
+        cache.swap(nextCache);
+
+        // Only triangles touching the cache changed score, the next one is among them
+        for (size_t i = 0; i < cache.size(); ++i) {
+            cachePosition[cache[i]] = i;
+            scores[cache[i]] = vertexScore(cache[i]);
+        }
+        best = -1;
+        float bestScore = -1;
+        for (ofIndexType v : cache) {
+            const uint32_t* triangles = &vertexTriangles[firstTriangle[v]];
+            for (uint32_t i = 0; i < remaining[v]; ++i) {
+                uint32_t t = triangles[i];
+                float score = scores[indices[t * 3]] + scores[indices[t * 3 + 1]] + scores[indices[t * 3 + 2]];
+                if (score > bestScore) {
+                    bestScore = score;
+                    best = t;
+                }
+            }
+        }
+    }
+    indices.swap(reordered);
+}
+
+// Welds, drops degenerate triangles and reorders mesh in place. Only
+// OF_PRIMITIVE_TRIANGLES meshes are touched, non-indexed ones come out
+// indexed.
+inline Stats optimize(ofMesh& mesh) {
+    Stats stats;
+    size_t numVertices = mesh.getNumVertices();
+    stats.verticesBefore = stats.verticesAfter = numVertices;
+    stats.indicesBefore = stats.indicesAfter = mesh.getNumIndices();
+    if (mesh.getMode() != OF_PRIMITIVE_TRIANGLES || numVertices == 0) {
+        return stats;
+    }
+    if (!mesh.hasIndices()) {
+        mesh.getIndices().resize(numVertices);
+        std::iota(mesh.getIndices().begin(), mesh.getIndices().end(), 0);
+    }
+    std::vector<ofIndexType>& indices = mesh.getIndices();
+    indices.resize(indices.size() / 3 * 3);
+    stats.indicesBefore = indices.size(); // elements drawn, also for non-indexed meshes
+    stats.cacheMissesBefore = cacheMisses(indices, numVertices);
+
+    std::vector<ofIndexType> remap;
+    weld(mesh, remap);
+
+    // Welded indices, without triangles that lost their area
+    const std::vector<glm::vec3>& positions = mesh.getVertices();
+    size_t kept = 0;
+    for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+        ofIndexType a = remap[indices[t]], b = remap[indices[t + 1]], c = remap[indices[t + 2]];
+        if (isDegenerate(positions[a], positions[b], positions[c])) {
+            continue;
+        }
+        indices[kept++] = a;
+        indices[kept++] = b;
+        indices[kept++] = c;
+    }
+    indices.resize(kept);
+
+    reorderForCache(indices, numVertices);
+
+    // Vertices in first use order, unreferenced ones dropped
+    std::vector<ofIndexType> newIndex(numVertices, std::numeric_limits<ofIndexType>::max());
+    std::vector<ofIndexType> order;
+    order.reserve(numVertices);
+    for (ofIndexType& index : indices) {
+        if (newIndex[index] == std::numeric_limits<ofIndexType>::max()) {
+            newIndex[index] = order.size();
+            order.push_back(index);
+        }
+        index = newIndex[index];
+    }
+    auto gather = [&](auto& attribute) {
+        if (attribute.size() != numVertices) {
+            attribute.clear();
+            return;
+        }
+        std::remove_reference_t<decltype(attribute)> gathered(order.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            gathered[i] = attribute[order[i]];
+        }
+        attribute.swap(gathered);
+    };
+    gather(mesh.getVertices());
+    gather(mesh.getNormals());
+    gather(mesh.getTexCoords());
+    gather(mesh.getColors());
+
+    stats.verticesAfter = mesh.getNumVertices();
+    stats.indicesAfter = indices.size();
+    stats.cacheMissesAfter = cacheMisses(indices, stats.verticesAfter);
+    return stats;
+}
+
+// Whether the mesh's indices fit GL_UNSIGNED_SHORT, the one rule for
+// GpuMesh uploads and MeshPack files
+inline bool fitsShortIndices(const ofMesh& mesh) {
+    return mesh.getNumVertices() <= 65536;
+}
+
+} // namespace meshopt
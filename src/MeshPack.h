@@ -0,0 +1,274 @@
+#pragma once
+#include "ofMain.h"
+#include "MeshOptimize.h"
+
+#ifndef TARGET_WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Binary file of meshes, so generated shapes can be loaded instead of
+// rebuilt. Every mesh is stored under a key, the call that generated it,
+// and the header carries a generator version to bump whenever a generator
+// changes its output. The file is memory mapped, reading a mesh is one
+// pass over its interleaved vertices and its indices, nothing is parsed.
+//
+//   header   "SHPK", format version, generator version, mesh count
+//   entries  offsets and counts of each mesh's vertices, indices and key
+//   vertices position, normal, texcoord, 32 bytes each
+//   indices  uint16 where meshopt::fitsShortIndices(), else uint32
+//   keys     characters, not terminated
+//
+// Only positions, normals, texcoords and indices are kept, not colors.
+class MeshPack {
+public:
+    static const uint32_t FORMAT_VERSION = 2;
+
+    ~MeshPack() {
+        close();
+    }
+
+    // False if the file is missing, malformed or from other generators
+    bool open(const std::string& path, uint32_t generatorVersion) {
+        close();
+        if (!map(path)) {
+            return false;
+        }
+        const Header* header = reinterpret_cast<const Header*>(data);
+        if (size < sizeof(Header) || std::memcmp(header->magic, "SHPK", 4) != 0 ||
+            header->formatVersion != FORMAT_VERSION || header->generatorVersion != generatorVersion ||
+            size < sizeof(Header) + header->numMeshes * sizeof(Entry)) {
+            ofLogNotice("MeshPack") << path << " is from another version, ignored";
+            close();
+            return false;
+        }
+        entries = reinterpret_cast<const Entry*>(data + sizeof(Header));
+        numMeshes = header->numMeshes;
+        for (size_t i = 0; i < numMeshes; ++i) {
+            const Entry& entry = entries[i];
+            if (entry.vertexOffset + uint64_t(entry.numVertices) * sizeof(Vertex) > size ||
+                entry.indexOffset + uint64_t(entry.numIndices) * indexSize(entry) > size ||
+                uint64_t(entry.keyOffset) + entry.keyLength > size) {
+                ofLogWarning("MeshPack") << path << " is truncated, ignored";
+                close();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void close() {
+#ifdef TARGET_WIN32
+        buffer.clear();
+#else
+        if (data) {
+            munmap(const_cast<char*>(data), size);
+        }
+#endif
+        data = nullptr;
+        size = 0;
+        entries = nullptr;
+        numMeshes = 0;
+    }
+
+    size_t getNumMeshes() const {
+        return numMeshes;
+    }
+
+    // Whether mesh index was stored under key
+    bool matches(size_t index, const std::string& key) const {
+        if (index >= numMeshes) {
+            return false;
+        }
+        const Entry& entry = entries[index];
+        return entry.keyLength == key.size() && std::memcmp(data + entry.keyOffset, key.data(), key.size()) == 0;
+    }
+
+    void read(size_t index, ofMesh& mesh) const {
+        const Entry& entry = entries[index];
+        const Vertex* vertices = reinterpret_cast<const Vertex*>(data + entry.vertexOffset);
+
+        mesh.clear();
+        mesh.setMode(static_cast<ofPrimitiveMode>(entry.mode));
+        mesh.getVertices().resize(entry.numVertices);
+        if (entry.flags & HAS_NORMALS) {
+            mesh.getNormals().resize(entry.numVertices);
+        }
+        if (entry.flags & HAS_TEXCOORDS) {
+            mesh.getTexCoords().resize(entry.numVertices);
+        }
+        for (size_t i = 0; i < entry.numVertices; ++i) {
+            const Vertex& vertex = vertices[i];
+            mesh.getVertices()[i] = glm::vec3(vertex.position[0], vertex.position[1], vertex.position[2]);
+            if (entry.flags & HAS_NORMALS) {
+                mesh.getNormals()[i] = glm::vec3(vertex.normal[0], vertex.normal[1], vertex.normal[2]);
+            }
+            if (entry.flags & HAS_TEXCOORDS) {
+                mesh.getTexCoords()[i] = glm::vec2(vertex.texCoord[0], vertex.texCoord[1]);
+            }
+        }
+        const char* indices = data + entry.indexOffset;
+        if (entry.flags & SHORT_INDICES) {
+            const uint16_t* shortIndices = reinterpret_cast<const uint16_t*>(indices);
+            mesh.getIndices().assign(shortIndices, shortIndices + entry.numIndices);
+        } else {
+            const uint32_t* longIndices = reinterpret_cast<const uint32_t*>(indices);
+            mesh.getIndices().assign(longIndices, longIndices + entry.numIndices);
+        }
+    }
+
+    // Writes meshes[i] under keys[i], through a temporary file so a crash
+    // never leaves a half written pack behind
+    static bool write(const std::string& path, uint32_t generatorVersion,
+                      const std::vector<const ofMesh*>& meshes, const std::vector<std::string>& keys) {
+        std::vector<Entry> table(meshes.size());
+        uint64_t offset = sizeof(Header) + meshes.size() * sizeof(Entry);
+        for (size_t i = 0; i < meshes.size(); ++i) {
+            const ofMesh& mesh = *meshes[i];
+            Entry& entry = table[i];
+            entry.numVertices = mesh.getNumVertices();
+            entry.numIndices = mesh.getNumIndices();
+            entry.mode = mesh.getMode();
+            entry.flags = (mesh.getNumNormals() == mesh.getNumVertices() ? HAS_NORMALS : 0)
+                        | (mesh.getNumTexCoords() == mesh.getNumVertices() ? HAS_TEXCOORDS : 0)
+                        | (meshopt::fitsShortIndices(mesh) ? SHORT_INDICES : 0);
+            entry.vertexOffset = offset;
+            offset += entry.numVertices * sizeof(Vertex);
+        }
+        for (auto& entry : table) {
+            // uint32 indices stay aligned after uint16 ones
+            offset = (offset + 3) / 4 * 4;
+            entry.indexOffset = offset;
+            offset += entry.numIndices * indexSize(entry);
+        }
+        for (size_t i = 0; i < meshes.size(); ++i) {
+            table[i].keyOffset = offset;
+            table[i].keyLength = keys[i].size();
+            offset += keys[i].size();
+        }
+
+        std::string temporary = path + ".tmp";
+        ofDirectory::createDirectory(ofFilePath::getEnclosingDirectory(path, false), false, true);
+        std::ofstream out(temporary, std::ios::binary);
+        Header header = {{'S', 'H', 'P', 'K'}, FORMAT_VERSION, generatorVersion, static_cast<uint32_t>(meshes.size())};
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(Entry));
+        std::vector<Vertex> vertices;
+        for (size_t i = 0; i < meshes.size(); ++i) {
+            const ofMesh& mesh = *meshes[i];
+            vertices.assign(mesh.getNumVertices(), Vertex());
+            for (size_t v = 0; v < vertices.size(); ++v) {
+                const glm::vec3& position = mesh.getVertices()[v];
+                vertices[v].position[0] = position.x;
+                vertices[v].position[1] = position.y;
+                vertices[v].position[2] = position.z;
+                if (table[i].flags & HAS_NORMALS) {
+                    const glm::vec3& normal = mesh.getNormals()[v];
+                    vertices[v].normal[0] = normal.x;
+                    vertices[v].normal[1] = normal.y;
+                    vertices[v].normal[2] = normal.z;
+                }
+                if (table[i].flags & HAS_TEXCOORDS) {
+                    vertices[v].texCoord[0] = mesh.getTexCoords()[v].x;
+                    vertices[v].texCoord[1] = mesh.getTexCoords()[v].y;
+                }
+            }
+            out.write(reinterpret_cast<const char*>(vertices.data()), vertices.size() * sizeof(Vertex));
+        }
+        for (size_t i = 0; i < meshes.size(); ++i) {
+            const std::vector<ofIndexType>& meshIndices = meshes[i]->getIndices();
+            out.seekp(table[i].indexOffset);
+            if (table[i].flags & SHORT_INDICES) {
+                std::vector<uint16_t> indices(meshIndices.begin(), meshIndices.end());
+                out.write(reinterpret_cast<const char*>(indices.data()), indices.size() * sizeof(uint16_t));
+            } else {
+                std::vector<uint32_t> indices(meshIndices.begin(), meshIndices.end());
+                out.write(reinterpret_cast<const char*>(indices.data()), indices.size() * sizeof(uint32_t));
+            }
+        }
+        for (auto& key : keys) {
+            out.write(key.data(), key.size());
+        }
+        out.close();
+        if (!out || std::rename(temporary.c_str(), path.c_str()) != 0) {
+            ofLogError("MeshPack") << "Couldn't write " << path;
+            std::remove(temporary.c_str());
+            return false;
+        }
+        return true;
+    }
+
+private:
+    enum Flags : uint32_t {
+        HAS_NORMALS = 1,
+        HAS_TEXCOORDS = 2,
+        SHORT_INDICES = 4
+    };
+
+    struct Header {
+        char magic[4];
+        uint32_t formatVersion;
+        uint32_t generatorVersion;
+        uint32_t numMeshes;
+    };
+
+    struct Entry {
+        uint64_t vertexOffset; // bytes from the start of the file
+        uint64_t indexOffset;
+        uint32_t numVertices;
+        uint32_t numIndices;
+        uint32_t mode; // ofPrimitiveMode
+        uint32_t flags;
+        uint32_t keyOffset;
+        uint32_t keyLength;
+    };
+
+    struct Vertex {
+        float position[3];
+        float normal[3];
+        float texCoord[2];
+    };
+
+    static uint64_t indexSize(const Entry& entry) {
+        return entry.flags & SHORT_INDICES ? sizeof(uint16_t) : sizeof(uint32_t);
+    }
+
+    bool map(const std::string& path) {
+#ifdef TARGET_WIN32
+        if (!ofFile::doesFileExist(path, false)) {
+            return false;
+        }
+        buffer = ofBufferFromFile(path, true);
+        data = buffer.getData();
+        size = buffer.size();
+        return size > 0;
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info;
+        void* mapped = MAP_FAILED;
+        if (fstat(fd, &info) == 0 && info.st_size > 0) {
+            mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        ::close(fd);
+        if (mapped == MAP_FAILED) {
+            return false;
+        }
+        data = static_cast<const char*>(mapped);
+        size = info.st_size;
+        return true;
+#endif
+    }
+
+#ifdef TARGET_WIN32
+    ofBuffer buffer;
+#endif
+    const char* data = nullptr;
+    size_t size = 0;
+    const Entry* entries = nullptr;
+    size_t numMeshes = 0;
+};
@@ -0,0 +1,42 @@
+#pragma once
+#include "ofMain.h"
+
+// Settings for rendering an audio file to frames instead of running live,
+// see --render in main.cpp
+struct OfflineRender {
+    std::string audioPath;
+    std::string outputDir = "render";
+    float fps = 30;
+    int width = 1920;
+    int height = 1080;
+    bool raw = false;
+
+    bool enabled() const {
+        return !audioPath.empty();
+    }
+
+    // --render <file.wav> [--out <dir>] [--fps <n>] [--size <w>x<h>] [--raw]
+    static OfflineRender fromArguments(int argc, char* argv[]) {
+        OfflineRender render;
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--render" && hasValue) {
+                render.audioPath = ofFilePath::getAbsolutePath(argv[++i], false);
+            } else if (arg == "--out" && hasValue) {
+                render.outputDir = ofFilePath::getAbsolutePath(argv[++i], false);
+            } else if (arg == "--fps" && hasValue) {
+                render.fps = std::max(1.0f, ofToFloat(argv[++i]));
+            } else if (arg == "--size" && hasValue) {
+                auto size = ofSplitString(argv[++i], "x");
+                if (size.size() == 2) {
+                    render.width = std::max(16, ofToInt(size[0]));
+                    render.height = std::max(16, ofToInt(size[1]));
+                }
+            } else if (arg == "--raw") {
+                render.raw = true;
+            }
+        }
+        return render;
+    }
+};
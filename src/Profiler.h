@@ -0,0 +1,284 @@
+#pragma once
+#include "ofMain.h"
+
+// Frame stage timings. CPU scopes can be used on any thread. GPU scopes use
+// GL timestamp queries that are read back a few frames later, so they never
+// stall the pipeline. Every stage keeps a rolling window of samples for the
+// p50/p95/p99 overlay, and while a trace is recording every scope is also
+// kept as an event for chrome://tracing (or ui.perfetto.dev).
+//
+//   PROFILE_SCOPE("stage");     // CPU time of the enclosing block
+//   PROFILE_GPU_SCOPE("pass");  // CPU and GPU time of the enclosing block
+class Profiler {
+public:
+    // Samples kept per stage for the percentiles
+    static const int WINDOW = 240;
+    // Frames a GPU query has to finish before it is read
+    static const int GPU_LATENCY = 4;
+
+    // Render thread, once the GL context exists
+    void setup() {
+#ifndef TARGET_OPENGLES
+        gpuTimers = glewIsSupported("GL_ARB_timer_query");
+#endif
+        if (gpuTimers) {
+            GLint64 gpuNow;
+            glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+            gpuOffset = static_cast<int64_t>(ofGetElapsedTimeMicros()) - gpuNow / 1000;
+        } else {
+            ofLogNotice("Profiler") << "No GL timer queries, GPU stages are not timed";
+        }
+    }
+
+    // Index of a named stage, registered on first use
+    int stage(const std::string& name) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t i = 0; i < stages.size(); ++i) {
+            if (stages[i].name == name) {
+                return i;
+            }
+        }
+        stages.emplace_back();
+        stages.back().name = name;
+        // Full size up front, adding samples never allocates
+        stages.back().cpu.values.reserve(WINDOW);
+        stages.back().gpu.values.reserve(WINDOW);
+        return stages.size() - 1;
+    }
+
+    void addCpu(int index, uint64_t start, uint64_t end) {
+        std::lock_guard<std::mutex> lock(mutex);
+        stages[index].cpu.add((end - start) / 1000.0f);
+        if (tracing) {
+            trace.push_back({index, threadId(), false, start, end - start});
+        }
+    }
+
+    // Render thread
+    void beginGpu(int index) {
+        if (!gpuTimers) {
+            return;
+        }
+        GpuFrame& frame = gpuFrames[gpuFrame];
+        frame.open.push_back(frame.queries.size());
+        frame.queries.push_back({index, query(frame, frame.used++), query(frame, frame.used++)});
+        glQueryCounter(frame.queries.back().begin, GL_TIMESTAMP);
+    }
+
+    void endGpu() {
+        if (!gpuTimers) {
+            return;
+        }
+        GpuFrame& frame = gpuFrames[gpuFrame];
+        glQueryCounter(frame.queries[frame.open.back()].end, GL_TIMESTAMP);
+        frame.open.pop_back();
+    }
+
+    // Render thread, once per frame before any GPU scope. Collects the
+    // queries of GPU_LATENCY frames ago if they are done, drops them if not.
+    void beginFrame() {
+        if (!gpuTimers) {
+            return;
+        }
+        gpuFrame = (gpuFrame + 1) % GPU_LATENCY;
+        GpuFrame& frame = gpuFrames[gpuFrame];
+        if (!frame.queries.empty()) {
+            GLint available = 0;
+            glGetQueryObjectiv(frame.queries.back().end, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (available) {
+                std::lock_guard<std::mutex> lock(mutex);
+                for (auto& q : frame.queries) {
+                    GLuint64 begin, end;
+                    glGetQueryObjectui64v(q.begin, GL_QUERY_RESULT, &begin);
+                    glGetQueryObjectui64v(q.end, GL_QUERY_RESULT, &end);
+                    stages[q.stage].gpu.add((end - begin) / 1e6f);
+                    if (tracing) {
+                        trace.push_back({q.stage, GPU_THREAD, true, static_cast<uint64_t>(gpuOffset + static_cast<int64_t>(begin / 1000)), (end - begin) / 1000});
+                    }
+                }
+            }
+        }
+        frame.queries.clear();
+        frame.open.clear();
+        frame.used = 0;
+    }
+
+    void drawOverlay(float x, float y) {
+        std::stringstream text;
+        text << std::fixed << std::setprecision(2);
+        text << "stage              cpu p50   p95   p99 ms   gpu p50   p95   p99 ms\n";
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (auto& stage : stages) {
+                text << std::left << std::setw(18) << stage.name.substr(0, 17) << std::right;
+                appendPercentiles(text, stage.cpu);
+                appendPercentiles(text, stage.gpu);
+                text << "\n";
+            }
+        }
+        if (tracing) {
+            text << "recording trace, " << trace.size() << " events\n";
+        }
+        ofDrawBitmapStringHighlight(text.str(), x, y);
+    }
+
+    bool isTracing() const {
+        return tracing;
+    }
+
+    void startTrace() {
+        std::lock_guard<std::mutex> lock(mutex);
+        trace.clear();
+        tracing = true;
+    }
+
+    // Writes the recorded events in the Chrome trace event format
+    void stopTrace(const std::string& path) {
+        std::vector<TraceEvent> events;
+        std::vector<std::string> names;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tracing = false;
+            events.swap(trace);
+            for (auto& stage : stages) {
+                names.push_back(stage.name);
+            }
+        }
+
+        std::ofstream out(ofToDataPath(path, true));
+        out << "{\"traceEvents\":[\n";
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << GPU_THREAD << ",\"args\":{\"name\":\"GPU\"}}";
+        for (auto& event : events) {
+            out << ",\n{\"name\":\"" << names[event.stage] << "\",\"cat\":\"" << (event.gpu ? "gpu" : "cpu")
+                << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread << ",\"ts\":" << event.start << ",\"dur\":" << event.duration << "}";
+        }
+        out << "\n]}\n";
+        ofLogNotice("Profiler") << "Wrote " << events.size() << " trace events to " << path;
+    }
+
+private:
+    static const int GPU_THREAD = 1000;
+
+    // Rolling window of milliseconds
+    struct Samples {
+        std::vector<float> values;
+        size_t next = 0;
+
+        void add(float ms) {
+            if (values.size() < WINDOW) {
+                values.push_back(ms);
+            } else {
+                values[next] = ms;
+            }
+            next = (next + 1) % WINDOW;
+        }
+    };
+
+    struct Stage {
+        std::string name;
+        Samples cpu;
+        Samples gpu;
+    };
+
+    struct GpuQuery {
+        int stage;
+        GLuint begin;
+        GLuint end;
+    };
+
+    struct GpuFrame {
+        std::vector<GLuint> pool;
+        size_t used = 0;
+        std::vector<GpuQuery> queries;
+        std::vector<size_t> open;
+    };
+
+    struct TraceEvent {
+        int stage;
+        int thread;
+        bool gpu;
+        uint64_t start; // microseconds
+        uint64_t duration;
+    };
+
+    static GLuint query(GpuFrame& frame, size_t index) {
+        if (index == frame.pool.size()) {
+            frame.pool.emplace_back();
+            glGenQueries(1, &frame.pool.back());
+        }
+        return frame.pool[index];
+    }
+
+    static void appendPercentiles(std::stringstream& text, const Samples& samples) {
+        if (samples.values.empty()) {
+            text << "      -     -     -   ";
+            return;
+        }
+        std::vector<float> sorted = samples.values;
+        std::sort(sorted.begin(), sorted.end());
+        for (float p : {0.5f, 0.95f, 0.99f}) {
+            text << std::setw(6) << sorted[std::min(sorted.size() - 1, static_cast<size_t>(p * sorted.size()))];
+        }
+        text << "   ";
+    }
+
+    // Small stable ids for the trace
+    int threadId() {
+        auto found = threads.find(std::this_thread::get_id());
+        if (found != threads.end()) {
+            return found->second;
+        }
+        int id = threads.size() + 1;
+        threads[std::this_thread::get_id()] = id;
+        return id;
+    }
+
+    std::mutex mutex;
+    std::vector<Stage> stages;
+    std::map<std::thread::id, int> threads;
+    bool tracing = false;
+    std::vector<TraceEvent> trace;
+
+    bool gpuTimers = false;
+    int64_t gpuOffset = 0;
+    GpuFrame gpuFrames[GPU_LATENCY];
+    int gpuFrame = 0;
+};
+
+inline Profiler& profiler() {
+    static Profiler instance;
+    return instance;
+}
+
+class ProfileScope {
+public:
+    explicit ProfileScope(int stage) : stage(stage), start(ofGetElapsedTimeMicros()) {}
+
+    ~ProfileScope() {
+        profiler().addCpu(stage, start, ofGetElapsedTimeMicros());
+    }
+
+private:
+    int stage;
+    uint64_t start;
+};
+
+class GpuProfileScope : public ProfileScope {
+public:
+    explicit GpuProfileScope(int stage) : ProfileScope(stage) {
+        profiler().beginGpu(stage);
+    }
+
+    ~GpuProfileScope() {
+        profiler().endGpu();
+    }
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(name) \
+    static const int PROFILE_CONCAT(profileStage, __LINE__) = profiler().stage(name); \
+    ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(PROFILE_CONCAT(profileStage, __LINE__))
+#define PROFILE_GPU_SCOPE(name) \
+    static const int PROFILE_CONCAT(profileStage, __LINE__) = profiler().stage(name); \
+    GpuProfileScope PROFILE_CONCAT(profileScope, __LINE__)(PROFILE_CONCAT(profileStage, __LINE__))
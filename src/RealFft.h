@@ -0,0 +1,219 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+// Real input FFT for power of two sizes. The n real samples are packed into
+// an n/2 point complex signal, transformed with radix-2 Stockham passes
+// (self-sorting, so there is no bit reversal) over split real/imaginary
+// arrays and unpacked into the n/2 + 1 bins of the real spectrum. The passes
+// are SSE vectorized, including the first two where the butterflies are
+// closer together than a vector.
+// This has no openFrameworks dependency so bench/ can build it on its own.
+namespace realfft {
+
+class Plan {
+public:
+    // n must be a power of two, at least 16
+    explicit Plan(size_t n) : n(n), m(n / 2) {
+        // Twiddles of every pass, exp(-2 pi i p / length) for p < length / 2
+        for (size_t length = m; length > 1; length /= 2) {
+            passOffsets.push_back(twiddleRe.size());
+            for (size_t p = 0; p < length / 2; ++p) {
+                double angle = -2.0 * M_PI * p / length;
+                twiddleRe.push_back(std::cos(angle));
+                twiddleIm.push_back(std::sin(angle));
+            }
+        }
+        // exp(-2 pi i k / n) to unpack the real spectrum
+        unpackRe.resize(m + 1);
+        unpackIm.resize(m + 1);
+        for (size_t k = 0; k <= m; ++k) {
+            double angle = -2.0 * M_PI * k / n;
+            unpackRe[k] = std::cos(angle);
+            unpackIm[k] = std::sin(angle);
+        }
+        for (auto* buffer : {&re[0], &im[0], &re[1], &im[1]}) {
+            buffer->resize(m);
+        }
+    }
+
+    size_t size() const {
+        return n;
+    }
+
+    size_t bins() const {
+        return m + 1;
+    }
+
+    // Spectrum of n real samples into bins() complex values
+    void forward(const float* in, float* outRe, float* outIm) {
+        transform(in, outRe, outIm, true);
+    }
+
+    // The same without SSE, for reference and benchmarking
+    void forwardScalar(const float* in, float* outRe, float* outIm) {
+        transform(in, outRe, outIm, false);
+    }
+
+private:
+    void transform(const float* in, float* outRe, float* outIm, bool simd) {
+        // Even samples become the real, odd ones the imaginary part
+        for (size_t k = 0; k < m; ++k) {
+            re[0][k] = in[2 * k];
+            im[0][k] = in[2 * k + 1];
+        }
+
+        int src = 0;
+        size_t stride = 1;
+        for (size_t pass = 0, length = m; length > 1; ++pass, length /= 2, stride *= 2) {
+            const float* wr = &twiddleRe[passOffsets[pass]];
+            const float* wi = &twiddleIm[passOffsets[pass]];
+            if (simd) {
+                passSimd(re[src].data(), im[src].data(), re[1 - src].data(), im[1 - src].data(), wr, wi, length / 2, stride);
+            } else {
+                passScalar(re[src].data(), im[src].data(), re[1 - src].data(), im[1 - src].data(), wr, wi, 0, length / 2, stride);
+            }
+            src = 1 - src;
+        }
+
+        // X[k] = E[k] + exp(-2 pi i k / n) O[k], with E and O the spectra of
+        // the even and odd samples recovered from Z[k] and conj(Z[m - k])
+        const float* zr = re[src].data();
+        const float* zi = im[src].data();
+        for (size_t k = 0; k <= m; ++k) {
+            size_t a = k == m ? 0 : k;
+            size_t b = k == 0 ? 0 : m - k;
+            float evenRe = 0.5f * (zr[a] + zr[b]);
+            float evenIm = 0.5f * (zi[a] - zi[b]);
+            float oddRe = 0.5f * (zi[a] + zi[b]);
+            float oddIm = -0.5f * (zr[a] - zr[b]);
+            outRe[k] = evenRe + unpackRe[k] * oddRe - unpackIm[k] * oddIm;
+            outIm[k] = evenIm + unpackRe[k] * oddIm + unpackIm[k] * oddRe;
+        }
+    }
+
+    // One radix-2 pass over butterflies p in [begin, end): the pair at
+    // q + stride * p and q + stride * (p + half) goes to q + stride * 2p
+    // (sum) and q + stride * (2p + 1) (difference times twiddle p)
+    static void passScalar(const float* xr, const float* xi, float* yr, float* yi,
+                           const float* wr, const float* wi, size_t begin, size_t half, size_t stride) {
+        for (size_t p = begin; p < half; ++p) {
+            for (size_t q = 0; q < stride; ++q) {
+                size_t a = q + stride * p;
+                size_t b = q + stride * (p + half);
+                float dr = xr[a] - xr[b];
+                float di = xi[a] - xi[b];
+                yr[q + stride * 2 * p] = xr[a] + xr[b];
+                yi[q + stride * 2 * p] = xi[a] + xi[b];
+                yr[q + stride * (2 * p + 1)] = dr * wr[p] - di * wi[p];
+                yi[q + stride * (2 * p + 1)] = dr * wi[p] + di * wr[p];
+            }
+        }
+    }
+
+#if defined(__SSE2__) || defined(_M_X64)
+
+    static void passSimd(const float* xr, const float* xi, float* yr, float* yi,
+                         const float* wr, const float* wi, size_t half, size_t stride) {
+        if (stride >= 4) {
+            // Four neighbouring butterflies share a twiddle
+            for (size_t p = 0; p < half; ++p) {
+                __m128 twr = _mm_set1_ps(wr[p]);
+                __m128 twi = _mm_set1_ps(wi[p]);
+                const float* ar = xr + stride * p;
+                const float* ai = xi + stride * p;
+                const float* br = xr + stride * (p + half);
+                const float* bi = xi + stride * (p + half);
+                float* sr = yr + stride * 2 * p;
+                float* si = yi + stride * 2 * p;
+                float* dr = yr + stride * (2 * p + 1);
+                float* di = yi + stride * (2 * p + 1);
+                for (size_t q = 0; q < stride; q += 4) {
+                    __m128 vr0 = _mm_loadu_ps(ar + q);
+                    __m128 vi0 = _mm_loadu_ps(ai + q);
+                    __m128 vr1 = _mm_loadu_ps(br + q);
+                    __m128 vi1 = _mm_loadu_ps(bi + q);
+                    __m128 subR = _mm_sub_ps(vr0, vr1);
+                    __m128 subI = _mm_sub_ps(vi0, vi1);
+                    _mm_storeu_ps(sr + q, _mm_add_ps(vr0, vr1));
+                    _mm_storeu_ps(si + q, _mm_add_ps(vi0, vi1));
+                    _mm_storeu_ps(dr + q, _mm_sub_ps(_mm_mul_ps(subR, twr), _mm_mul_ps(subI, twi)));
+                    _mm_storeu_ps(di + q, _mm_add_ps(_mm_mul_ps(subR, twi), _mm_mul_ps(subI, twr)));
+                }
+            }
+        } else if (stride == 2) {
+            // Lanes are (p, 0) (p, 1) (p + 1, 0) (p + 1, 1), sums and
+            // differences interleave in pairs
+            size_t p = 0;
+            for (; p + 2 <= half; p += 2) {
+                __m128 twr = _mm_setr_ps(wr[p], wr[p], wr[p + 1], wr[p + 1]);
+                __m128 twi = _mm_setr_ps(wi[p], wi[p], wi[p + 1], wi[p + 1]);
+                __m128 vr0 = _mm_loadu_ps(xr + 2 * p);
+                __m128 vi0 = _mm_loadu_ps(xi + 2 * p);
+                __m128 vr1 = _mm_loadu_ps(xr + 2 * (p + half));
+                __m128 vi1 = _mm_loadu_ps(xi + 2 * (p + half));
+                __m128 sumR = _mm_add_ps(vr0, vr1);
+                __m128 sumI = _mm_add_ps(vi0, vi1);
+                __m128 subR = _mm_sub_ps(vr0, vr1);
+                __m128 subI = _mm_sub_ps(vi0, vi1);
+                __m128 difR = _mm_sub_ps(_mm_mul_ps(subR, twr), _mm_mul_ps(subI, twi));
+                __m128 difI = _mm_add_ps(_mm_mul_ps(subR, twi), _mm_mul_ps(subI, twr));
+                _mm_storeu_ps(yr + 4 * p, _mm_movelh_ps(sumR, difR));
+                _mm_storeu_ps(yi + 4 * p, _mm_movelh_ps(sumI, difI));
+                _mm_storeu_ps(yr + 4 * p + 4, _mm_movehl_ps(difR, sumR));
+                _mm_storeu_ps(yi + 4 * p + 4, _mm_movehl_ps(difI, sumI));
+            }
+            passScalar(xr, xi, yr, yi, wr, wi, p, half, stride);
+        } else {
+            // Lanes are p .. p + 3, sums and differences interleave
+            size_t p = 0;
+            for (; p + 4 <= half; p += 4) {
+                __m128 twr = _mm_loadu_ps(wr + p);
+                __m128 twi = _mm_loadu_ps(wi + p);
+                __m128 vr0 = _mm_loadu_ps(xr + p);
+                __m128 vi0 = _mm_loadu_ps(xi + p);
+                __m128 vr1 = _mm_loadu_ps(xr + p + half);
+                __m128 vi1 = _mm_loadu_ps(xi + p + half);
+                __m128 sumR = _mm_add_ps(vr0, vr1);
+                __m128 sumI = _mm_add_ps(vi0, vi1);
+                __m128 subR = _mm_sub_ps(vr0, vr1);
+                __m128 subI = _mm_sub_ps(vi0, vi1);
+                __m128 difR = _mm_sub_ps(_mm_mul_ps(subR, twr), _mm_mul_ps(subI, twi));
+                __m128 difI = _mm_add_ps(_mm_mul_ps(subR, twi), _mm_mul_ps(subI, twr));
+                _mm_storeu_ps(yr + 2 * p, _mm_unpacklo_ps(sumR, difR));
+                _mm_storeu_ps(yi + 2 * p, _mm_unpacklo_ps(sumI, difI));
+                _mm_storeu_ps(yr + 2 * p + 4, _mm_unpackhi_ps(sumR, difR));
+                _mm_storeu_ps(yi + 2 * p + 4, _mm_unpackhi_ps(sumI, difI));
+            }
+            passScalar(xr, xi, yr, yi, wr, wi, p, half, stride);
+        }
+    }
+
+#else
+
+    static void passSimd(const float* xr, const float* xi, float* yr, float* yi,
+                         const float* wr, const float* wi, size_t half, size_t stride) {
+        passScalar(xr, xi, yr, yi, wr, wi, 0, half, stride);
+    }
+
+#endif
+
+    size_t n;
+    size_t m;
+    std::vector<size_t> passOffsets;
+    std::vector<float> twiddleRe;
+    std::vector<float> twiddleIm;
+    std::vector<float> unpackRe;
+    std::vector<float> unpackIm;
+    std::vector<float> re[2];
+    std::vector<float> im[2];
+};
+
+} // namespace realfft
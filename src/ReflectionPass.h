@@ -0,0 +1,179 @@
+#pragma once
+#include "ofMain.h"
+
+// How much the water reflection costs, see --reflection-* in main.cpp
+struct ReflectionQuality {
+    float scale = 0.5f; // of the window size, 1, 0.5 or 0.25
+    int interval = 1;   // re-render every interval frames
+    bool blur = false;  // soften the upsampled reflection
+
+    // [--reflection-scale 1|0.5|0.25] [--reflection-interval <n>] [--reflection-blur]
+    static ReflectionQuality fromArguments(int argc, char* argv[]) {
+        ReflectionQuality quality;
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--reflection-scale" && hasValue) {
+                quality.scale = ofClamp(ofToFloat(argv[++i]), 0.25f, 1.0f);
+            } else if (arg == "--reflection-interval" && hasValue) {
+                quality.interval = std::max(1, ofToInt(argv[++i]));
+            } else if (arg == "--reflection-blur") {
+                quality.blur = true;
+            }
+        }
+        return quality;
+    }
+};
+
+// Planar reflection in the horizontal plane y = height. Shapes are drawn
+// through the camera with their model matrices mirrored about the plane
+// (getMirrorMatrix()), and an oblique near plane clips away everything on
+// the far side of the water, so only what is above it gets rasterized. The water shader looks the result
+// up projectively with getTextureMatrix().
+// The target is rendered at a fraction of the window size and only every few
+// frames, the lookup's bilinear filtering upsamples it. The water only
+// blends a little of it in, so the lost detail doesn't show.
+//
+//   if (reflection.beginFrame()) {
+//       reflection.begin(cam, height);
+//       shape->drawMirrored(reflection.getMirrorMatrix());
+//       reflection.end(cam);
+//   }
+//   reflection.getTexture().bind(1);
+//   shader.setUniformMatrix4f("reflectionMatrix", reflection.getTextureMatrix(ofGetCurrentViewMatrix()));
+class ReflectionPass {
+public:
+    void setup(int windowWidth, int windowHeight, const ReflectionQuality& reflectionQuality) {
+        quality = reflectionQuality;
+        if (quality.blur && !blurShader.isLoaded() && !blurShader.load("shaders/blur/blur")) {
+            ofLogError("ReflectionPass") << "Blur shader failed to load, reflection stays sharp";
+            quality.blur = false;
+        }
+        allocate(windowWidth, windowHeight);
+        ofLogNotice("ReflectionPass") << fbo.getWidth() << "x" << fbo.getHeight() << ", every "
+                                      << quality.interval << " frames" << (quality.blur ? ", blurred" : "");
+    }
+
+    // Window size changed, the next frame re-renders
+    void resize(int windowWidth, int windowHeight) {
+        if (fbo.isAllocated()) {
+            allocate(windowWidth, windowHeight);
+        }
+    }
+
+    // Once per frame, whether the reflection is due to be re-rendered
+    bool beginFrame() {
+        bool due = stale || frame % quality.interval == 0;
+        frame++;
+        return due;
+    }
+
+    void begin(ofCamera& cam, float planeHeight) {
+        height = planeHeight;
+        fbo.begin();
+        ofClear(0, 0, 0, 255);
+        cam.begin();
+        glm::mat4 view = ofGetCurrentViewMatrix();
+        ofSetMatrixMode(OF_MATRIX_PROJECTION);
+        ofLoadMatrix(obliqueProjection(cam.getProjectionMatrix(), view));
+        ofSetMatrixMode(OF_MATRIX_MODELVIEW);
+        viewProjection = ofGetCurrentMatrix(OF_MATRIX_PROJECTION) * ofGetCurrentMatrix(OF_MATRIX_MODELVIEW);
+    }
+
+    void end(ofCamera& cam) {
+        cam.end();
+        fbo.end();
+        if (quality.blur) {
+            blur();
+        }
+        stale = false;
+    }
+
+    const ofTexture& getTexture() const {
+        return fbo.getTexture();
+    }
+
+    // Maps the eye space of a pass with the given view matrix to the
+    // reflection's clip space. Points on the plane are their own mirror
+    // image, so for the water surface this is where its reflection was drawn.
+    glm::mat4 getTextureMatrix(const glm::mat4& view) const {
+        return viewProjection * glm::inverse(view);
+    }
+
+    // World space reflection about the plane, y becomes 2 height - y
+    glm::mat4 getMirrorMatrix() const {
+        glm::mat4 mirror(1.0f);
+        mirror[1][1] = -1.0f;
+        mirror[3][1] = 2.0f * height;
+        return mirror;
+    }
+
+    glm::vec3 mirror(const glm::vec3& point) const {
+        return glm::vec3(point.x, 2.0f * height - point.y, point.z);
+    }
+
+private:
+    void allocate(int windowWidth, int windowHeight) {
+        int width = std::max(1, static_cast<int>(windowWidth * quality.scale));
+        int height = std::max(1, static_cast<int>(windowHeight * quality.scale));
+        // The mirrored scene needs depth, the blur target doesn't
+        ofFboSettings settings;
+        settings.width = width;
+        settings.height = height;
+        settings.internalformat = GL_RGBA;
+        settings.useDepth = true;
+        settings.minFilter = GL_LINEAR;
+        settings.maxFilter = GL_LINEAR;
+        settings.wrapModeHorizontal = GL_CLAMP_TO_EDGE;
+        settings.wrapModeVertical = GL_CLAMP_TO_EDGE;
+        fbo.allocate(settings);
+        if (quality.blur) {
+            settings.useDepth = false;
+            blurFbo.allocate(settings);
+        }
+        stale = true;
+    }
+
+    // Replaces the near plane of projection with the water plane (Lengyel,
+    // "Oblique View Frustum Depth Projection and Clipping"), keeping the
+    // mirrored side y >= height. The camera has to be on the other side.
+    glm::mat4 obliqueProjection(glm::mat4 projection, const glm::mat4& view) const {
+        glm::vec4 plane = glm::transpose(glm::inverse(view)) * glm::vec4(0, 1, 0, -height);
+        if (plane.w >= 0) {
+            // Camera below the water, nothing sensible to clip
+            return projection;
+        }
+        glm::vec4 corner = glm::inverse(projection) * glm::vec4(glm::sign(plane.x), glm::sign(plane.y), 1, 1);
+        glm::vec4 row4(projection[0][3], projection[1][3], projection[2][3], projection[3][3]);
+        glm::vec4 row3 = plane * (2.0f * glm::dot(row4, corner) / glm::dot(plane, corner)) - row4;
+        for (int column = 0; column < 4; ++column) {
+            projection[column][2] = row3[column];
+        }
+        return projection;
+    }
+
+    // Separable Gaussian, horizontally into blurFbo and vertically back
+    void blur() {
+        ofDisableDepthTest();
+        blurShader.begin();
+        blurShader.setUniform2f("texelStep", 1.0f / fbo.getWidth(), 0.0f);
+        blurFbo.begin();
+        fbo.draw(0, 0);
+        blurFbo.end();
+        blurShader.setUniform2f("texelStep", 0.0f, 1.0f / fbo.getHeight());
+        fbo.begin();
+        blurFbo.draw(0, 0);
+        fbo.end();
+        blurShader.end();
+        ofEnableDepthTest();
+    }
+
+    ReflectionQuality quality;
+    float height = 0;
+    glm::mat4 viewProjection = glm::mat4(1.0f); // of the last render
+    ofFbo fbo;
+    ofFbo blurFbo;
+    ofShader blurShader;
+    uint64_t frame = 0;
+    bool stale = true;
+};
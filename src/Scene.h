@@ -0,0 +1,25 @@
+#pragma once
+#include "ofMain.h"
+#include "DeformKernel.h"
+
+// A transformed copy of a library shape, as built by createPregeom. Everything
+// here is derived once when the scene is generated, update() only adds the FFT.
+struct Submesh {
+    int shapeIndex; // into ofApp::precomputedGeometries
+    int size;
+    float fileScale;
+    glm::mat4 transform; // the copy's transform in postMult order, for instanced drawing
+    size_t vertexOffset; // of the copy's first vertex in Scene::geometry
+    deform::Positions positions; // transformed vertices as structure-of-arrays for the deform kernel
+};
+
+// Everything a regeneration produces. Scenes are built off the render thread
+// so this only holds CPU side data, ofApp::applyScene does the GL uploads.
+struct Scene {
+    std::vector<Submesh> submeshes;
+    ofColor color;
+
+    // Combined geometry for the CPU path, without per-vertex colors. Its
+    // topology never changes, every frame only overwrites the vertices.
+    ofMesh geometry;
+};
@@ -0,0 +1,49 @@
+#pragma once
+#include "ofMain.h"
+#include "Scene.h"
+
+// Builds the next Scene on a worker thread. The render thread asks for one
+// with request() and polls tryReceive() each frame, so a regeneration never
+// stalls a frame and the swap always happens between two frames.
+class SceneBuilder : public ofThread {
+public:
+    // Fills in a scene from an FFT snapshot, runs on the worker thread
+    std::function<void(Scene&, const std::vector<float>&)> build;
+
+    ~SceneBuilder() {
+        stop();
+    }
+
+    void request(const std::vector<float>& fftValues) {
+        requests.send(fftValues);
+    }
+
+    bool tryReceive(std::unique_ptr<Scene>& scene) {
+        return built.tryReceive(scene);
+    }
+
+    // Blocks until the requested scene is built
+    bool receive(std::unique_ptr<Scene>& scene) {
+        return built.receive(scene);
+    }
+
+    void stop() {
+        requests.close();
+        built.close();
+        waitForThread(false);
+    }
+
+protected:
+    void threadedFunction() override {
+        std::vector<float> fftValues;
+        while (requests.receive(fftValues)) {
+            auto scene = std::make_unique<Scene>();
+            build(*scene, fftValues);
+            built.send(std::move(scene));
+        }
+    }
+
+private:
+    ofThreadChannel<std::vector<float>> requests;
+    ofThreadChannel<std::unique_ptr<Scene>> built;
+};
@@ -0,0 +1,75 @@
+#pragma once
+#include "BaseShape.h"
+
+// The set of shapes scenes are composed from. It is filled once at startup
+// and frozen, after which it is read-only: shapes keep a stable index for the
+// lifetime of the app and are shared by every regeneration, including the
+// ones built on the SceneBuilder thread.
+class ShapeLibrary {
+public:
+    // Returns the new shape's index, or -1 once the library is frozen. key
+    // identifies how the shape was generated, for the mesh cache.
+    int add(std::shared_ptr<BaseShape> shape, const std::string& key = "") {
+        if (frozen) {
+            ofLogError("ShapeLibrary") << "add() after freeze(), shape ignored";
+            return -1;
+        }
+        shapes.push_back(std::move(shape));
+        keys.push_back(key);
+        return shapes.size() - 1;
+    }
+
+    void freeze() {
+        frozen = true;
+    }
+
+    bool isFrozen() const {
+        return frozen;
+    }
+
+    bool empty() const {
+        return shapes.empty();
+    }
+
+    size_t size() const {
+        return shapes.size();
+    }
+
+    const BaseShape& at(int index) const {
+        return *shapes.at(index);
+    }
+
+    const std::string& getKey(int index) const {
+        return keys.at(index);
+    }
+
+    size_t numVertices() const {
+        size_t total = 0;
+        for (auto& shape : shapes) {
+            total += shape->mesh.getNumVertices();
+        }
+        return total;
+    }
+
+    // Bytes held by the shapes' vertex attributes and indices
+    size_t footprintBytes() const {
+        size_t total = 0;
+        for (auto& shape : shapes) {
+            total += meshBytes(shape->mesh);
+        }
+        return total;
+    }
+
+    static size_t meshBytes(const ofMesh& mesh) {
+        return mesh.getNumVertices() * sizeof(glm::vec3)
+             + mesh.getNumNormals() * sizeof(glm::vec3)
+             + mesh.getNumTexCoords() * sizeof(glm::vec2)
+             + mesh.getNumColors() * sizeof(ofFloatColor)
+             + mesh.getNumIndices() * sizeof(ofIndexType);
+    }
+
+private:
+    std::vector<std::shared_ptr<BaseShape>> shapes;
+    std::vector<std::string> keys;
+    bool frozen = false;
+};
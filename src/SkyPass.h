@@ -0,0 +1,38 @@
+#pragma once
+#include "ofMain.h"
+
+// The sky as a background stage. One triangle covers the screen at the far
+// plane and is drawn after the opaque geometry with GL_LEQUAL, so only
+// pixels nothing else has covered run the sky shader.
+class SkyPass {
+public:
+    bool setup() {
+        // Clip space corners, the triangle overhangs the screen on two sides
+        glm::vec3 corners[3] = {{-1, -1, 0}, {3, -1, 0}, {-1, 3, 0}};
+        triangle.setVertexData(corners, 3, GL_STATIC_DRAW);
+        if (!shader.load("shaders/sky/sky")) {
+            ofLogError("SkyPass") << "Sky shader failed to load";
+            return false;
+        }
+        return true;
+    }
+
+    // Needs depth test enabled and the depth buffer of the finished scene
+    void draw(const ofTexture& skyTexture) {
+        if (!shader.isLoaded()) {
+            return;
+        }
+        glDepthFunc(GL_LEQUAL);
+        glDepthMask(GL_FALSE);
+        shader.begin();
+        shader.setUniformTexture("skyTexture", skyTexture, 0);
+        triangle.draw(GL_TRIANGLES, 0, 3);
+        shader.end();
+        glDepthMask(GL_TRUE);
+        glDepthFunc(GL_LESS);
+    }
+
+private:
+    ofVbo triangle;
+    ofShader shader;
+};
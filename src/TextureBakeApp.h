@@ -0,0 +1,15 @@
+#pragma once
+#include "ofMain.h"
+#include "TextureCache.h"
+
+// Offline bake step, run with --bake-textures. Bakes every image under
+// bin/data/textures into the compressed files TextureStreamer prefers, then exits.
+class TextureBakeApp : public ofBaseApp {
+public:
+    void setup() override {
+        uint64_t start = ofGetElapsedTimeMillis();
+        int baked = texcache::bakeDirectory("textures");
+        ofLogNotice("TextureBakeApp") << "Baked " << baked << " textures in " << ofGetElapsedTimeMillis() - start << " ms";
+        ofExit();
+    }
+};
@@ -0,0 +1,246 @@
+#pragma once
+#include "ofMain.h"
+
+// Pre-baked, GPU ready versions of the images in bin/data/textures. Each
+// source image gets a KTX (version 1) file next to it holding a DXT1 (or DXT5
+// when the image has alpha) compressed mip chain, so loading it is a file read
+// and a compressed upload instead of a JPEG/TIFF decode, and it takes 4-8x
+// less VRAM than the decoded RGB(A) texture.
+//
+// Baking uses the GL driver's S3TC encoder and needs a context, run the app
+// with --bake-textures to (re)bake everything. Missing baked files fall back
+// to decoding the source image.
+namespace texcache {
+
+struct Level {
+    size_t offset; // into CompressedImage::file
+    size_t size;
+    int width;
+    int height;
+};
+
+struct CompressedImage {
+    ofBuffer file;
+    GLenum internalFormat = 0;
+    int width = 0;
+    int height = 0;
+    std::vector<Level> levels;
+};
+
+static const unsigned char KTX_IDENTIFIER[12] = {0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n'};
+static const uint32_t KTX_ENDIANNESS = 0x04030201;
+
+// textures/water/001.jpg -> textures/water/001.ktx
+inline std::string bakedPath(const std::string& sourcePath) {
+    return ofFilePath::removeExt(sourcePath) + ".ktx";
+}
+
+// Reads and validates a baked file, safe to call off the render thread
+inline bool load(const std::string& path, CompressedImage& image) {
+    image.file = ofBufferFromFile(path, true);
+    const char* data = image.file.getData();
+    size_t size = image.file.size();
+
+    uint32_t header[13];
+    if (size < sizeof(KTX_IDENTIFIER) + sizeof(header) || memcmp(data, KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER)) != 0) {
+        return false;
+    }
+    memcpy(header, data + sizeof(KTX_IDENTIFIER), sizeof(header));
+    if (header[0] != KTX_ENDIANNESS) {
+        return false;
+    }
+
+    image.internalFormat = header[4];
+    image.width = header[6];
+    image.height = header[7];
+    uint32_t numLevels = std::max<uint32_t>(header[11], 1);
+    size_t offset = sizeof(KTX_IDENTIFIER) + sizeof(header) + header[12];
+
+    image.levels.clear();
+    int width = image.width;
+    int height = image.height;
+    for (uint32_t i = 0; i < numLevels; ++i) {
+        uint32_t imageSize;
+        if (offset + sizeof(imageSize) > size) {
+            return false;
+        }
+        memcpy(&imageSize, data + offset, sizeof(imageSize));
+        offset += sizeof(imageSize);
+        if (offset + imageSize > size) {
+            return false;
+        }
+
+        image.levels.push_back({offset, imageSize, width, height});
+        offset += (imageSize + 3) & ~3u;
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+    }
+    return true;
+}
+
+// Specifies every mip level of texture from the baked data. With base set the
+// data is read from client memory, with nullptr from the level offsets in the
+// buffer bound to GL_PIXEL_UNPACK_BUFFER.
+inline void upload(ofTexture& texture, const CompressedImage& image, const char* base) {
+    const ofTextureData& data = texture.getTextureData();
+    glBindTexture(data.textureTarget, data.textureID);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    for (size_t i = 0; i < image.levels.size(); ++i) {
+        const Level& level = image.levels[i];
+        const void* pixels = base ? static_cast<const void*>(base + level.offset) : reinterpret_cast<const void*>(level.offset);
+        glCompressedTexImage2D(data.textureTarget, i, image.internalFormat, level.width, level.height, 0, level.size, pixels);
+    }
+
+    glTexParameteri(data.textureTarget, GL_TEXTURE_MAX_LEVEL, image.levels.size() - 1);
+    glTexParameteri(data.textureTarget, GL_TEXTURE_MIN_FILTER, image.levels.size() > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(data.textureTarget, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(data.textureTarget, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(data.textureTarget, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(data.textureTarget, 0);
+}
+
+// 2x2 box filter for the next mip level
+inline ofPixels downsample(const ofPixels& src) {
+    int width = std::max<int>(1, src.getWidth() / 2);
+    int height = std::max<int>(1, src.getHeight() / 2);
+    int channels = src.getNumChannels();
+
+    ofPixels dst;
+    dst.allocate(width, height, channels);
+    for (int y = 0; y < height; ++y) {
+        int y0 = std::min<int>(y * 2, src.getHeight() - 1);
+        int y1 = std::min<int>(y * 2 + 1, src.getHeight() - 1);
+        for (int x = 0; x < width; ++x) {
+            int x0 = std::min<int>(x * 2, src.getWidth() - 1);
+            int x1 = std::min<int>(x * 2 + 1, src.getWidth() - 1);
+            for (int c = 0; c < channels; ++c) {
+                int sum = src[(y0 * src.getWidth() + x0) * channels + c]
+                        + src[(y0 * src.getWidth() + x1) * channels + c]
+                        + src[(y1 * src.getWidth() + x0) * channels + c]
+                        + src[(y1 * src.getWidth() + x1) * channels + c];
+                dst[(y * width + x) * channels + c] = (sum + 2) / 4;
+            }
+        }
+    }
+    return dst;
+}
+
+// Compresses sourcePath into a baked file at bakedPath, needs a GL context
+inline bool bake(const std::string& sourcePath, const std::string& destPath) {
+    ofPixels pixels;
+    if (!ofLoadImage(pixels, sourcePath)) {
+        ofLogError("texcache") << "Failed to load " << sourcePath;
+        return false;
+    }
+    bool alpha = pixels.getNumChannels() == 4;
+    if (!alpha && pixels.getNumChannels() != 3) {
+        pixels.setImageType(OF_IMAGE_COLOR);
+    }
+    GLenum internalFormat = alpha ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    GLenum baseFormat = alpha ? GL_RGBA : GL_RGB;
+
+    GLuint id;
+    glGenTextures(1, &id);
+    glBindTexture(GL_TEXTURE_2D, id);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+    // Let the driver compress each level, then read the blocks back
+    std::vector<std::vector<char>> levels;
+    ofPixels level = pixels;
+    bool ok = true;
+    for (int i = 0; ok; ++i) {
+        glTexImage2D(GL_TEXTURE_2D, i, internalFormat, level.getWidth(), level.getHeight(), 0, baseFormat, GL_UNSIGNED_BYTE, level.getData());
+
+        GLint compressed = GL_FALSE;
+        GLint size = 0;
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, i, GL_TEXTURE_COMPRESSED, &compressed);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, i, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &size);
+        if (compressed != GL_TRUE || size <= 0) {
+            ofLogError("texcache") << "Driver did not compress " << sourcePath << ", is S3TC supported?";
+            ok = false;
+            break;
+        }
+
+        levels.emplace_back(size);
+        glGetCompressedTexImage(GL_TEXTURE_2D, i, levels.back().data());
+
+        if (level.getWidth() == 1 && level.getHeight() == 1) {
+            break;
+        }
+        level = downsample(level);
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDeleteTextures(1, &id);
+    if (!ok) {
+        return false;
+    }
+
+    uint32_t header[13] = {
+        KTX_ENDIANNESS,
+        0,              // glType, 0 for compressed
+        1,              // glTypeSize
+        0,              // glFormat, 0 for compressed
+        internalFormat,
+        baseFormat,
+        static_cast<uint32_t>(pixels.getWidth()),
+        static_cast<uint32_t>(pixels.getHeight()),
+        0,              // depth
+        0,              // array elements
+        1,              // faces
+        static_cast<uint32_t>(levels.size()),
+        0               // key/value bytes
+    };
+
+    ofBuffer out;
+    out.append(reinterpret_cast<const char*>(KTX_IDENTIFIER), sizeof(KTX_IDENTIFIER));
+    out.append(reinterpret_cast<const char*>(header), sizeof(header));
+    for (auto& bytes : levels) {
+        uint32_t imageSize = bytes.size();
+        out.append(reinterpret_cast<const char*>(&imageSize), sizeof(imageSize));
+        out.append(bytes.data(), bytes.size());
+        // mip padding, DXT blocks already are multiples of 4
+        static const char padding[3] = {0, 0, 0};
+        out.append(padding, (4 - imageSize % 4) % 4);
+    }
+    return ofBufferToFile(destPath, out, true);
+}
+
+// Bakes every image under dir (recursively) that has no up to date baked file
+inline int bakeDirectory(const std::string& dir) {
+    int baked = 0;
+    ofDirectory directory(dir);
+    directory.listDir();
+    for (auto& file : directory) {
+        if (file.isDirectory()) {
+            baked += bakeDirectory(file.path());
+            continue;
+        }
+        std::string ext = ofToLower(file.getExtension());
+        if (ext != "jpg" && ext != "jpeg" && ext != "tif" && ext != "tiff" && ext != "png") {
+            continue;
+        }
+
+        std::string dest = bakedPath(file.path());
+        ofFile destFile(dest);
+        if (destFile.exists() && std::filesystem::last_write_time(destFile.getAbsolutePath()) >= std::filesystem::last_write_time(file.getAbsolutePath())) {
+            continue;
+        }
+
+        uint64_t start = ofGetElapsedTimeMillis();
+        if (bake(file.path(), dest)) {
+            ofLogNotice("texcache") << "Baked " << dest << " (" << ofFile(dest).getSize() / 1024 << " KB, "
+                                    << ofGetElapsedTimeMillis() - start << " ms)";
+            baked++;
+        }
+    }
+    return baked;
+}
+
+} // namespace texcache
@@ -0,0 +1,224 @@
+#pragma once
+#include "ofMain.h"
+#include "TextureCache.h"
+
+// Streams a randomly picked image from a list into a texture without
+// stalling the render thread. The next image is decoded and copied into a
+// pixel buffer object on a worker thread ahead of time, uploaded from the
+// PBO, and only becomes the visible texture once a fence says the upload is
+// complete. Baked files from TextureCache.h are preferred over decoding the
+// source image. update() must be called once per frame from the render thread.
+// Images that fail to load are skipped from then on.
+class TextureStreamer : public ofThread {
+public:
+    ~TextureStreamer() {
+        stop();
+    }
+
+    void setup(const std::vector<std::string>& imagePaths, const std::string& streamName) {
+        paths = imagePaths;
+        name = streamName;
+        // Own generator, ofRandom() is also used on the SceneBuilder thread.
+        // Seeded from it here so ofSeedRandom() still fixes the sequence.
+        random.seed(static_cast<uint32_t>(ofRandom(1 << 30)));
+        startThread();
+    }
+
+    // Blocking load of the first image that loads, then starts prefetching the next one
+    void loadFirst() {
+        for (std::string path = pickPath(); !path.empty(); path = pickPath()) {
+            if (ofFile::doesFileExist(texcache::bakedPath(path)) && texcache::load(texcache::bakedPath(path), compressedImage)) {
+                textures[front].allocate(compressedImage.width, compressedImage.height, GL_RGB8);
+                texcache::upload(textures[front], compressedImage, compressedImage.file.getData());
+                compressedTexture[front] = true;
+                break;
+            } else if (ofLoadImage(pixels, path)) {
+                textures[front].loadData(pixels);
+                textures[front].setTextureWrap(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+                break;
+            }
+            ofLogError("TextureStreamer") << "Failed to load " << path;
+            failed.insert(path);
+        }
+        prefetch();
+    }
+
+    // Switch to the prefetched image as soon as it is resident
+    void requestSwap() {
+        swapRequested = true;
+    }
+
+    const ofTexture& getTexture() const {
+        return textures[front];
+    }
+
+    void update() {
+        switch (state.load()) {
+        case Failed:
+            // Try another image, each one fails at most once
+            failed.insert(prefetching);
+            prefetch();
+            break;
+
+        case Decoded: {
+            // Map the PBO here, the worker fills it
+            size_t bytes = compressed ? compressedImage.file.size() : pixels.getTotalBytes();
+            const void* source = compressed ? static_cast<const void*>(compressedImage.file.getData()) : static_cast<const void*>(pixels.getData());
+            if (pbo.size() < static_cast<GLsizeiptr>(bytes)) {
+                pbo.allocate(bytes, GL_STREAM_DRAW);
+            }
+            mapped = pbo.mapRange(0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+            state = Copying;
+            jobs.send([this, source, bytes] {
+                memcpy(mapped, source, bytes);
+                state = Copied;
+            });
+            break;
+        }
+
+        case Copied: {
+            pbo.unmap();
+            mapped = nullptr;
+
+            int back = 1 - front;
+            int width = compressed ? compressedImage.width : pixels.getWidth();
+            int height = compressed ? compressedImage.height : pixels.getHeight();
+            if (!textures[back].isAllocated() || textures[back].getWidth() != width || textures[back].getHeight() != height
+                || compressedTexture[back] != compressed) {
+                // a fresh texture object, compressed levels can't be overwritten with glTexSubImage2D
+                textures[back].clear();
+                textures[back].allocate(width, height, compressed ? GL_RGB8 : ofGetGLInternalFormat(pixels));
+                textures[back].setTextureWrap(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+                compressedTexture[back] = compressed;
+            }
+
+            uploadStart = ofGetElapsedTimeMicros();
+            if (compressed) {
+                pbo.bind(GL_PIXEL_UNPACK_BUFFER);
+                texcache::upload(textures[back], compressedImage, nullptr);
+                pbo.unbind(GL_PIXEL_UNPACK_BUFFER);
+            } else {
+                textures[back].loadData(pbo, ofGetGLFormat(pixels), GL_UNSIGNED_BYTE);
+            }
+            fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            state = Uploading;
+            break;
+        }
+
+        case Uploading: {
+            GLenum result = glClientWaitSync(fence, 0, 0);
+            if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED) {
+                glDeleteSync(fence);
+                fence = nullptr;
+                float uploadMs = (ofGetElapsedTimeMicros() - uploadStart) / 1000.0f;
+                ofLogNotice("TextureStreamer") << name << (compressed ? " baked" : "") << " texture "
+                                               << textures[1 - front].getWidth() << "x" << textures[1 - front].getHeight()
+                                               << " decode " << decodeMs << " ms, upload " << uploadMs << " ms";
+                state = Resident;
+            }
+            break;
+        }
+
+        default:
+            break;
+        }
+
+        if (swapRequested && state == Resident) {
+            front = 1 - front;
+            swapRequested = false;
+            prefetch();
+        }
+    }
+
+    void stop() {
+        jobs.close();
+        waitForThread(false);
+        if (fence != nullptr) {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+
+protected:
+    void threadedFunction() override {
+        std::function<void()> job;
+        while (jobs.receive(job)) {
+            job();
+        }
+    }
+
+private:
+    enum State {
+        Idle,      // nothing prefetched, loadFirst() and swaps start a decode
+        Failed,    // the prefetched image didn't load, another one is picked
+        Decoding,  // worker is decoding into pixels
+        Decoded,   // waiting for the render thread to map the PBO
+        Copying,   // worker is copying pixels into the mapped PBO
+        Copied,    // waiting for the render thread to start the upload
+        Uploading, // upload issued, waiting on its fence
+        Resident   // the back texture is ready to be shown
+    };
+
+    // A random path that hasn't failed yet, empty once all of them have
+    std::string pickPath() {
+        std::vector<const std::string*> candidates;
+        for (auto& path : paths) {
+            if (failed.count(path) == 0) {
+                candidates.push_back(&path);
+            }
+        }
+        if (candidates.empty()) {
+            return "";
+        }
+        return *candidates[std::uniform_int_distribution<size_t>(0, candidates.size() - 1)(random)];
+    }
+
+    void prefetch() {
+        std::string path = pickPath();
+        if (path.empty()) {
+            ofLogError("TextureStreamer") << "No " << name << " image loads, keeping the current one";
+            state = Idle;
+            return;
+        }
+        prefetching = path;
+        state = Decoding;
+        jobs.send([this, path] {
+            uint64_t start = ofGetElapsedTimeMicros();
+            std::string baked = texcache::bakedPath(path);
+            compressed = ofFile::doesFileExist(baked) && texcache::load(baked, compressedImage);
+            if (compressed || ofLoadImage(pixels, path)) {
+                decodeMs = (ofGetElapsedTimeMicros() - start) / 1000.0f;
+                state = Decoded;
+            } else {
+                ofLogError("TextureStreamer") << "Failed to load " << path;
+                state = Failed;
+            }
+        });
+    }
+
+    std::vector<std::string> paths;
+    std::string name;
+    std::mt19937 random;
+    std::set<std::string> failed; // render thread only
+    std::string prefetching;     // the path the worker is loading
+
+    ofTexture textures[2];
+    int front = 0;
+    bool swapRequested = false;
+
+    std::atomic<State> state{Idle};
+    ofThreadChannel<std::function<void()>> jobs;
+
+    // owned by whoever state says is working on them
+    ofPixels pixels;
+    texcache::CompressedImage compressedImage;
+    bool compressed = false;
+    bool compressedTexture[2] = {false, false};
+
+    ofBufferObject pbo;
+    void* mapped = nullptr;
+    GLsync fence = nullptr;
+
+    float decodeMs = 0;
+    uint64_t uploadStart = 0;
+};
@@ -0,0 +1,188 @@
+#pragma once
+#include "ofMain.h"
+
+// Fixed set of worker threads for data parallel loops. Every worker has its
+// own task queue, takes its newest task first and steals the oldest ones of
+// the others when it runs dry, and the thread waiting in parallelFor() helps
+// along. Tasks live in fixed size rings and point at the caller's stack, so
+// a parallelFor() doesn't allocate.
+//
+//   pool.parallelFor(items.size(), [&](size_t i) { process(items[i]); });
+class ThreadPool {
+public:
+    // Tasks a queue holds, further ones run on the calling thread
+    static const size_t QUEUE_CAPACITY = 1024;
+
+    // One worker per core besides the calling thread by default
+    explicit ThreadPool(size_t numWorkers = std::max(1u, std::thread::hardware_concurrency()) - 1) {
+        for (size_t i = 0; i < std::max<size_t>(numWorkers, 1); ++i) {
+            queues.push_back(std::make_unique<Queue>());
+        }
+        for (size_t i = 0; i < queues.size(); ++i) {
+            workers.push_back(std::make_unique<Worker>(*this, i));
+            workers.back()->startThread();
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& worker : workers) {
+            worker->waitForThread(false);
+        }
+    }
+
+    size_t getNumWorkers() const {
+        return workers.size();
+    }
+
+    // Runs body(i) for every i < count and returns once all of them have
+    // finished. Iterations may run in any order and on any thread. Only one
+    // thread may call this at a time.
+    template<typename F>
+    void parallelFor(size_t count, F&& body) {
+        if (count == 0) {
+            return;
+        }
+        Batch batch;
+        batch.body = &body;
+        batch.run = [](void* f, size_t i) {
+            (*static_cast<typename std::remove_reference<F>::type*>(f))(i);
+        };
+        batch.remaining = count;
+
+        size_t queued = 0;
+        for (size_t i = 0; i < count; ++i) {
+            // Counted first, a worker may take the task the moment it is pushed
+            pending++;
+            if (queues[(next + i) % queues.size()]->push({&batch, i})) {
+                queued++;
+            } else {
+                pending--;
+                run({&batch, i});
+            }
+        }
+        next = (next + count) % queues.size();
+        if (queued > 0) {
+            {
+                // Taken so a worker can't miss the notify between its check and its wait
+                std::lock_guard<std::mutex> lock(sleepMutex);
+            }
+            wake.notify_all();
+        }
+
+        // Help instead of blocking, the batch's tasks are the likeliest to be found
+        while (batch.remaining > 0) {
+            Task task;
+            if (steal(queues.size(), task)) {
+                pending--;
+                run(task);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+private:
+    struct Batch {
+        void (*run)(void* body, size_t index);
+        void* body;
+        std::atomic<size_t> remaining;
+    };
+
+    struct Task {
+        Batch* batch;
+        size_t index;
+    };
+
+    // Bounded deque, the owner pops at the back, thieves at the front
+    struct Queue {
+        std::mutex mutex;
+        Task tasks[QUEUE_CAPACITY];
+        size_t head = 0; // oldest task
+        size_t size = 0;
+
+        bool push(const Task& task) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (size == QUEUE_CAPACITY) {
+                return false;
+            }
+            tasks[(head + size++) % QUEUE_CAPACITY] = task;
+            return true;
+        }
+
+        bool popBack(Task& task) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (size == 0) {
+                return false;
+            }
+            task = tasks[(head + --size) % QUEUE_CAPACITY];
+            return true;
+        }
+
+        bool popFront(Task& task) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (size == 0) {
+                return false;
+            }
+            task = tasks[head];
+            head = (head + 1) % QUEUE_CAPACITY;
+            size--;
+            return true;
+        }
+    };
+
+    class Worker : public ofThread {
+    public:
+        Worker(ThreadPool& owner, size_t index) : pool(owner), index(index) {}
+
+    protected:
+        void threadedFunction() override {
+            while (true) {
+                Task task;
+                if (pool.queues[index]->popBack(task) || pool.steal(index, task)) {
+                    pool.pending--;
+                    pool.run(task);
+                    continue;
+                }
+                std::unique_lock<std::mutex> lock(pool.sleepMutex);
+                pool.wake.wait(lock, [this] { return pool.stopping || pool.pending > 0; });
+                if (pool.stopping) {
+                    return;
+                }
+            }
+        }
+
+    private:
+        ThreadPool& pool;
+        size_t index;
+    };
+
+    // Oldest task of any queue but the thief's own
+    bool steal(size_t thief, Task& task) {
+        for (size_t i = 1; i <= queues.size(); ++i) {
+            size_t victim = (thief + i) % queues.size();
+            if (victim != thief && queues[victim]->popFront(task)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void run(const Task& task) {
+        task.batch->run(task.batch->body, task.index);
+        task.batch->remaining--;
+    }
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::unique_ptr<Worker>> workers;
+    size_t next = 0; // queue the next batch starts filling
+
+    std::atomic<size_t> pending{0}; // queued tasks, for waking and sleeping workers
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    bool stopping = false;
+};
@@ -0,0 +1,41 @@
+#pragma once
+#include <atomic>
+
+// Lock-free single producer, single consumer triple buffer. The writer fills
+// write() and publish()es it, the reader calls update() to take the newest
+// published value and then reads read() for as long as it likes. Neither
+// side ever waits, copies or sees a half written value.
+template<typename T>
+class TripleBuffer {
+public:
+    // Writer side
+    T& write() {
+        return buffers[back];
+    }
+
+    void publish() {
+        back = middle.exchange(back | FRESH) & INDEX;
+    }
+
+    // Reader side, returns true if a newer value was taken
+    bool update() {
+        if ((middle.load() & FRESH) == 0) {
+            return false;
+        }
+        front = middle.exchange(front) & INDEX;
+        return true;
+    }
+
+    const T& read() const {
+        return buffers[front];
+    }
+
+private:
+    static const int INDEX = 3;
+    static const int FRESH = 4;
+
+    T buffers[3];
+    int back = 0;
+    std::atomic<int> middle{1};
+    int front = 2;
+};
@@ -0,0 +1,131 @@
+#pragma once
+#include "ofMain.h"
+
+// Tube geometry swept along a polyline, shared by Antenna, Tentacle, Leg and
+// TentacleStraight. Rings of `segments` vertices are oriented with parallel
+// transport frames (double reflection, Wang et al. 2008) so they don't twist
+// or flip where the path turns, and the buffers are sized up front and
+// written in place.
+namespace tube {
+
+inline ofMesh generate(const std::vector<glm::vec3>& points, float radius, int segments) {
+    ofMesh mesh;
+    mesh.setMode(OF_PRIMITIVE_TRIANGLES);
+    size_t numPoints = points.size();
+    if (numPoints < 2 || segments < 3) {
+        return mesh;
+    }
+
+    std::vector<glm::vec3>& vertices = mesh.getVertices();
+    std::vector<glm::vec3>& normals = mesh.getNormals();
+    std::vector<glm::vec2>& texCoords = mesh.getTexCoords();
+    std::vector<ofIndexType>& indices = mesh.getIndices();
+    vertices.resize(numPoints * segments);
+    normals.resize(numPoints * segments);
+    texCoords.resize(numPoints * segments);
+    indices.resize((numPoints - 1) * segments * 6);
+
+    // Tangents, central differences inside the path
+    std::vector<glm::vec3> tangents(numPoints);
+    for (size_t i = 0; i < numPoints; ++i) {
+        glm::vec3 prev = points[i == 0 ? 0 : i - 1];
+        glm::vec3 next = points[i == numPoints - 1 ? i : i + 1];
+        tangents[i] = glm::normalize(next - prev);
+    }
+
+    // First frame as before: perpendicular to the tangent and the z axis
+    glm::vec3 reference = std::abs(tangents[0].z) > 0.99f ? glm::vec3(0, 1, 0) : glm::vec3(0, 0, 1);
+    glm::vec3 normal = glm::normalize(glm::cross(tangents[0], reference));
+
+    // Ring sines/cosines are the same for every ring
+    std::vector<float> cosines(segments);
+    std::vector<float> sines(segments);
+    for (int j = 0; j < segments; ++j) {
+        float theta = TWO_PI * j / segments;
+        cosines[j] = cos(theta);
+        sines[j] = sin(theta);
+    }
+
+    for (size_t i = 0; i < numPoints; ++i) {
+        if (i > 0) {
+            // Carry the previous frame along the segment
+            glm::vec3 v1 = points[i] - points[i - 1];
+            float c1 = glm::dot(v1, v1);
+            if (c1 > 0) {
+                glm::vec3 normalL = normal - (2.0f / c1) * glm::dot(v1, normal) * v1;
+                glm::vec3 tangentL = tangents[i - 1] - (2.0f / c1) * glm::dot(v1, tangents[i - 1]) * v1;
+                glm::vec3 v2 = tangents[i] - tangentL;
+                float c2 = glm::dot(v2, v2);
+                normal = c2 > 0 ? normalL - (2.0f / c2) * glm::dot(v2, normalL) * v2 : normalL;
+                normal = glm::normalize(normal);
+            }
+        }
+        glm::vec3 binormal = glm::cross(tangents[i], normal);
+
+        size_t ring = i * segments;
+        for (int j = 0; j < segments; ++j) {
+            glm::vec3 direction = cosines[j] * normal + sines[j] * binormal;
+            vertices[ring + j] = points[i] + radius * direction;
+            normals[ring + j] = direction;
+            texCoords[ring + j] = glm::vec2(j / (float)segments, i / (float)numPoints);
+        }
+    }
+
+    // Two triangles per quad between neighbouring rings
+    ofIndexType* index = indices.data();
+    for (size_t i = 0; i + 1 < numPoints; ++i) {
+        for (int j = 0; j < segments; ++j) {
+            int nextSegment = (j + 1) % segments;
+            ofIndexType currentIndex = i * segments + j;
+            ofIndexType nextIndex = (i + 1) * segments + j;
+            ofIndexType nextSegmentIndex = i * segments + nextSegment;
+            ofIndexType nextIndexSegment = (i + 1) * segments + nextSegment;
+
+            *index++ = currentIndex;
+            *index++ = nextIndex;
+            *index++ = nextIndexSegment;
+
+            *index++ = currentIndex;
+            *index++ = nextIndexSegment;
+            *index++ = nextSegmentIndex;
+        }
+    }
+
+    return mesh;
+}
+
+// Memoized generate(), identical tubes are built once and shared. Safe to
+// call from several threads.
+inline std::shared_ptr<const ofMesh> sweep(const ofPolyline& line, float radius, int segments) {
+    struct Key {
+        std::vector<float> points;
+        float radius;
+        int segments;
+
+        bool operator<(const Key& other) const {
+            return std::tie(segments, radius, points) < std::tie(other.segments, other.radius, other.points);
+        }
+    };
+    static std::map<Key, std::shared_ptr<const ofMesh>> cache;
+    static std::mutex mutex;
+
+    const std::vector<glm::vec3>& points = line.getVertices();
+    Key key;
+    key.points.reserve(points.size() * 3);
+    for (auto& point : points) {
+        key.points.insert(key.points.end(), {point.x, point.y, point.z});
+    }
+    key.radius = radius;
+    key.segments = segments;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = cache.find(key);
+    if (found != cache.end()) {
+        return found->second;
+    }
+    auto mesh = std::make_shared<const ofMesh>(generate(points, radius, segments));
+    cache.emplace(std::move(key), mesh);
+    return mesh;
+}
+
+} // namespace tube
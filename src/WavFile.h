@@ -0,0 +1,95 @@
+#pragma once
+#include "ofMain.h"
+
+// Minimal RIFF/WAVE reader for the offline render mode. Handles 8/16/24/32
+// bit integer PCM and 32 bit float, plain or WAVE_FORMAT_EXTENSIBLE, and
+// mixes every channel down to mono.
+struct WavFile {
+    int sampleRate = 0;
+    int channels = 0;
+    std::vector<float> samples; // mono
+
+    float getDuration() const {
+        return sampleRate > 0 ? static_cast<float>(samples.size()) / sampleRate : 0.0f;
+    }
+
+    bool load(const std::string& path) {
+        ofBuffer file = ofBufferFromFile(path, true);
+        const unsigned char* data = reinterpret_cast<const unsigned char*>(file.getData());
+        size_t size = file.size();
+        if (size < 12 || memcmp(data, "RIFF", 4) != 0 || memcmp(data + 8, "WAVE", 4) != 0) {
+            ofLogError("WavFile") << path << " is not a WAVE file";
+            return false;
+        }
+
+        int format = 0;
+        int bits = 0;
+        const unsigned char* pcm = nullptr;
+        size_t pcmSize = 0;
+        for (size_t offset = 12; offset + 8 <= size;) {
+            uint32_t chunkSize = read32(data + offset + 4);
+            const unsigned char* chunk = data + offset + 8;
+            size_t available = std::min<size_t>(chunkSize, size - offset - 8);
+            if (memcmp(data + offset, "fmt ", 4) == 0 && available >= 16) {
+                format = read16(chunk);
+                channels = read16(chunk + 2);
+                sampleRate = read32(chunk + 4);
+                bits = read16(chunk + 14);
+                if (format == 0xFFFE && available >= 26) {
+                    format = read16(chunk + 24); // sub format GUID starts with the format code
+                }
+            } else if (memcmp(data + offset, "data", 4) == 0) {
+                pcm = chunk;
+                pcmSize = available;
+            }
+            offset += 8 + chunkSize + (chunkSize & 1);
+        }
+
+        bool supported = (format == 1 && (bits == 8 || bits == 16 || bits == 24 || bits == 32)) || (format == 3 && bits == 32);
+        if (pcm == nullptr || channels <= 0 || sampleRate <= 0 || !supported) {
+            ofLogError("WavFile") << path << ": unsupported format " << format << ", " << bits << " bit, " << channels << " channels";
+            return false;
+        }
+
+        int bytes = bits / 8;
+        size_t frames = pcmSize / (bytes * channels);
+        samples.assign(frames, 0.0f);
+        for (size_t i = 0; i < frames; ++i) {
+            float sum = 0;
+            for (int c = 0; c < channels; ++c) {
+                sum += sample(pcm + (i * channels + c) * bytes, format, bits);
+            }
+            samples[i] = sum / channels;
+        }
+        ofLogNotice("WavFile") << path << ": " << sampleRate << " Hz, " << channels << " channels, " << bits << " bit, "
+                               << getDuration() << " s";
+        return true;
+    }
+
+private:
+    static uint16_t read16(const unsigned char* p) {
+        return p[0] | (p[1] << 8);
+    }
+
+    static uint32_t read32(const unsigned char* p) {
+        return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+    }
+
+    static float sample(const unsigned char* p, int format, int bits) {
+        switch (bits) {
+        case 8:
+            return (p[0] - 128) / 128.0f;
+        case 16:
+            return static_cast<int16_t>(read16(p)) / 32768.0f;
+        case 24:
+            return static_cast<int32_t>((p[0] << 8) | (p[1] << 16) | (static_cast<uint32_t>(p[2]) << 24)) / 2147483648.0f;
+        default:
+            if (format == 3) {
+                float value;
+                memcpy(&value, p, sizeof(value));
+                return value;
+            }
+            return static_cast<int32_t>(read32(p)) / 2147483648.0f;
+        }
+    }
+};
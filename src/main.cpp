@@ -1,8 +1,20 @@
+#ifdef DEBUG
+// Backs the "heap allocations in update()" line of the debug overlay
+#define COUNT_ALLOCATIONS
+#include "AllocationCounter.h"
+#endif
 #include "ofMain.h"
 #include "ofApp.h"
+#include "TextureBakeApp.h"
+#ifndef OF_TARGET_OPENGLES
+#include "ofAppGLFWWindow.h"
+#endif
 
 //========================================================================
-int main( ){
+int main(int argc, char* argv[]){
+	bool bakeTextures = argc > 1 && std::string(argv[1]) == "--bake-textures";
+	OfflineRender render = OfflineRender::fromArguments(argc, argv);
+	ReflectionQuality reflection = ReflectionQuality::fromArguments(argc, argv);
 
 #ifdef OF_TARGET_OPENGLES
 	ofGLESWindowSettings settings;
@@ -12,13 +24,40 @@ int main( ){
 	settings.setGLVersion(3,2);
 #endif
 
+	if (bakeTextures) {
+		settings.setSize(256, 256);
+		auto window = ofCreateWindow(settings);
+		ofRunApp(window, make_shared<TextureBakeApp>());
+		return ofRunMainLoop();
+	}
+
+	if (render.enabled()) {
+		// Everything goes to an FBO, the window only provides the context
+#ifdef OF_TARGET_OPENGLES
+		ofGLESWindowSettings renderSettings = settings;
+#else
+		ofGLFWWindowSettings renderSettings;
+		renderSettings.setGLVersion(3,2);
+		renderSettings.visible = false;
+#endif
+		renderSettings.setSize(render.width, render.height);
+		auto window = ofCreateWindow(renderSettings);
+		auto app = make_shared<ofApp>();
+		app->offlineRender = render;
+		app->reflectionQuality = reflection;
+		ofRunApp(window, app);
+		return ofRunMainLoop();
+	}
+
 	auto window = ofCreateWindow(settings);
 
     settings.windowMode = OF_FULLSCREEN;  // Set fullscreen mode
     settings.setSize(1920, 1080);         // Optionally, set your desired screen resolution
     ofCreateWindow(settings);
 
-	ofRunApp(window, make_shared<ofApp>());
+	auto app = make_shared<ofApp>();
+	app->reflectionQuality = reflection;
+	ofRunApp(window, app);
 	ofRunMainLoop();
 
 }
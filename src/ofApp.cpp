@@ -11,43 +11,31 @@ float textureSwapTimer = 0.0f;
 int currentTextureIndex = 0;
 
 vector<string> waterTextures = {
-    "textures/water/001.jpg",
-    "textures/water/025.jpg",
-    "textures/water/051.jpg",
-    "textures/water/053.jpg",
-    "textures/water/060.jpg",
-    "textures/water/081.jpg",
+    "textures/water/001.JPG",
+    "textures/water/025.JPG",
+    "textures/water/051.JPG",
+    "textures/water/053.JPG",
+    "textures/water/060.JPG",
+    "textures/water/081.JPG",
     "textures/water/110.jpg"
 };
 
 vector<string> skyTextures = {
-    "textures/sky/077.jpg",
-    "textures/sky/078.jpg",
-    "textures/sky/080.jpg",
-    "textures/sky/099.jpg",
-    "textures/sky/102.jpg",
-    "textures/sky/104.jpg",
-    "textures/sky/111.jpg",
-    "textures/sky/115.jpg",
-    "textures/sky/117.jpg"
+    "textures/sky/077.JPG",
+    "textures/sky/078.JPG",
+    "textures/sky/080.JPG",
+    "textures/sky/099.JPG",
+    "textures/sky/102.JPG",
+    "textures/sky/104.JPG",
+    "textures/sky/111.JPG",
+    "textures/sky/115.JPG",
+    "textures/sky/117.JPG"
 };
 
+// Both streams have the next image prefetched, this flips to it once it is resident
 void ofApp::loadNextTextures() {
-    int randomWaterIndex = static_cast<int>(ofRandom(0, waterTextures.size()));
-    if(waterImage.load(waterTextures[randomWaterIndex])) {
-        waterImage.getTexture().setTextureWrap(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
-        ofLogNotice() << "Water texture loaded successfully!";
-    } else {
-        ofLogError() << "Failed to load water texture!";
-    }
-
-    int randomSkyIndex = static_cast<int>(ofRandom(0, skyTextures.size()));
-    if(skyImage.load(skyTextures[randomSkyIndex])) {
-        skyImage.getTexture().setTextureWrap(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
-        ofLogNotice() << "Sky texture loaded successfully!";
-    } else {
-        ofLogError() << "Failed to load Sky texture!";
-    }
+    waterStreamer.requestSwap();
+    skyStreamer.requestSwap();
 }
 
 
@@ -281,120 +269,191 @@ ofMesh createTorusKnotMesh(float radius, float tubeRadius, int radialSegments, i
     return mesh;
 }
 
+// A library shape's generator call, as the cache key and as the code to run
+// when the cache doesn't have it
+#define SHAPE(generator) #generator, [] { return std::shared_ptr<BaseShape>(generator); }
+
 void ofApp::generateTestGeometries() {
     // Legs
-    addGeom(make_shared<Leg>(4, 3), ofVec3f(1, 1, 0), ofVec3f(0, 0, 0), ofVec3f(1, 1, 1));
-    addGeom(make_shared<Leg>(4, 6), ofVec3f(0, 0, 0), ofVec3f(0, 0, 0), ofVec3f(1, 1, 1));
-    addGeom(make_shared<Leg>(5, 3), ofVec3f(0, 0, PI / 2), ofVec3f(0, 0, 0), ofVec3f(1, 1, 1));
-    addGeom(make_shared<Leg>(6, 4), ofVec3f(0, -(PI / 2), 0), ofVec3f(0, 0, 0), ofVec3f(1, 1, 1));
-    addGeom(make_shared<Leg>(7, 3), ofVec3f(0, PI / 2, PI / 2), ofVec3f(0, 0, 0), ofVec3f(1, 1, 1));
-    addGeom(make_shared<Leg>(8, 5), ofVec3f(0, 1, 0), ofVec3f(0, 0, 0), ofVec3f(1, 1, 1));
-    addGeom(make_shared<Leg>(9, 2), ofVec3f(0, 0, 0), ofVec3f(0, 0, 0), ofVec3f(1, 1, 1));
-    addGeom(make_shared<Leg>(10, 6), ofVec3f(0, 0, PI / 2), ofVec3f(0, 0, 0), ofVec3f(1, 1, 1));
+    addGeom(SHAPE(make_shared<Leg>(4, 3)), ofVec3f(1, 1, 0), ofVec3f(0, 0, 0), ofVec3f(1, 1, 1));
+    addGeom(SHAPE(make_shared<Leg>(4, 6)), ofVec3f(0, 0, 0), ofVec3f(0, 0, 0), ofVec3f(1, 1, 1));
+    addGeom(SHAPE(make_shared<Leg>(5, 3)), ofVec3f(0, 0, PI / 2), ofVec3f(0, 0, 0), ofVec3f(1, 1, 1));
+    addGeom(SHAPE(make_shared<Leg>(6, 4)), ofVec3f(0, -(PI / 2), 0), ofVec3f(0, 0, 0), ofVec3f(1, 1, 1));
+    addGeom(SHAPE(make_shared<Leg>(7, 3)), ofVec3f(0, PI / 2, PI / 2), ofVec3f(0, 0, 0), ofVec3f(1, 1, 1));
+    addGeom(SHAPE(make_shared<Leg>(8, 5)), ofVec3f(0, 1, 0), ofVec3f(0, 0, 0), ofVec3f(1, 1, 1));
+    addGeom(SHAPE(make_shared<Leg>(9, 2)), ofVec3f(0, 0, 0), ofVec3f(0, 0, 0), ofVec3f(1, 1, 1));
+    addGeom(SHAPE(make_shared<Leg>(10, 6)), ofVec3f(0, 0, PI / 2), ofVec3f(0, 0, 0), ofVec3f(1, 1, 1));
 }
 
 
-void ofApp::generateGeometries() {
+// Loads the shape library from the mesh cache, generating and re-caching
+// whatever isn't in it. Shapes are built on the thread pool into fixed
+// slots and added in the order generateLibraryShapes() lists them, so
+// library indices don't depend on which thread finished first. Generated
+// meshes are welded and reordered by meshopt::optimize() before caching.
+// Without useCache every shape is generated and the cache is left alone.
+void ofApp::generateGeometries(bool useCache) {
+    float start = ofGetElapsedTimef();
+    shapeRecipes.clear();
+    generateLibraryShapes();
+
+    std::string cachePath = ofToDataPath(SHAPE_CACHE_PATH, true);
+    MeshPack shapeCache;
+    if (useCache) {
+        shapeCache.open(cachePath, SHAPE_GENERATOR_VERSION);
+    }
+    std::vector<shared_ptr<BaseShape>> shapes(shapeRecipes.size());
+    std::atomic<size_t> generated{0};
+    meshopt::Stats optimized;
+    std::mutex optimizedMutex;
+    threadPool.parallelFor(shapeRecipes.size(), [&](size_t i) {
+        const ShapeRecipe& recipe = shapeRecipes[i];
+        shared_ptr<BaseShape> geom;
+        if (shapeCache.matches(i, recipe.key)) {
+            geom = make_shared<BaseShape>();
+            shapeCache.read(i, geom->mesh);
+        } else {
+            geom = recipe.generate();
+            meshopt::Stats stats = meshopt::optimize(geom->mesh);
+            generated++;
+            std::lock_guard<std::mutex> lock(optimizedMutex);
+            optimized += stats;
+        }
+        geom->applyScale(recipe.scale);
+        geom->applyRotation(recipe.rotation);
+        geom->applyTranslation(recipe.translation);
+        shapes[i] = geom;
+    });
+
+    for (size_t i = 0; i < shapes.size(); ++i) {
+        precomputedGeometries.add(shapes[i], shapeRecipes[i].key);
+    }
+    if (useCache && (generated > 0 || shapeCache.getNumMeshes() != shapes.size())) {
+        std::vector<const ofMesh*> meshes;
+        std::vector<std::string> keys;
+        for (size_t i = 0; i < precomputedGeometries.size(); ++i) {
+            meshes.push_back(&precomputedGeometries.at(i).mesh);
+            keys.push_back(precomputedGeometries.getKey(i));
+        }
+        MeshPack::write(cachePath, SHAPE_GENERATOR_VERSION, meshes, keys);
+    }
+    shapeCache.close();
+    shapeRecipes.clear();
+    if (generated > 0) {
+        ofLogNotice() << "Generated shapes optimized: " << optimized.verticesBefore << " -> " << optimized.verticesAfter
+                      << " vertices, " << optimized.indicesBefore << " -> " << optimized.indicesAfter << " indices, "
+                      << optimized.cacheMissesBefore * 3.0f / std::max<size_t>(optimized.indicesBefore, 1) << " -> "
+                      << optimized.cacheMissesAfter * 3.0f / std::max<size_t>(optimized.indicesAfter, 1)
+                      << " vertex cache misses per triangle";
+    }
+    ofLogNotice() << "Shape library: " << shapes.size() << " shapes, " << generated << " generated, "
+                  << (shapes.size() - generated) << " from " SHAPE_CACHE_PATH " on " << threadPool.getNumWorkers() + 1
+                  << " threads in " << (ofGetElapsedTimef() - start) * 1000 << " ms";
+}
+
+void ofApp::generateLibraryShapes() {
     // Rocks
-    addGeom(make_shared<BaseShape>(createTetrahedronMesh(80)), ofVec3f(0, 0, 0), ofVec3f(40, 0, 0), ofVec3f(1, 1, 1));
-    addGeom(make_shared<BaseShape>(createTetrahedronMesh(80)), ofVec3f(0, 0, 0), ofVec3f(20, 0, 0), ofVec3f(1, 1, 1));
-    addGeom(make_shared<BaseShape>(createTetrahedronMesh(80)), ofVec3f(0, 0, 0), ofVec3f(0, -40, 0), ofVec3f(1, 1, 1));
-	addGeom(make_shared<BaseShape>(createTetrahedronMesh(80)), ofVec3f(0, 0, 0), ofVec3f(40, 0, 0), ofVec3f(1, 1, 1));
-    addGeom(make_shared<BaseShape>(createTetrahedronMesh(120)), ofVec3f(0, 0, 0), ofVec3f(20, 0, 0), ofVec3f(1, 1, 1));
-    addGeom(make_shared<BaseShape>(createTetrahedronMesh(120)), ofVec3f(0, 0, 0), ofVec3f(0, -40, 0), ofVec3f(1, 1, 1));
+    addGeom(SHAPE(make_shared<BaseShape>(createTetrahedronMesh(80))), ofVec3f(0, 0, 0), ofVec3f(40, 0, 0), ofVec3f(1, 1, 1));
+    addGeom(SHAPE(make_shared<BaseShape>(createTetrahedronMesh(80))), ofVec3f(0, 0, 0), ofVec3f(20, 0, 0), ofVec3f(1, 1, 1));
+    addGeom(SHAPE(make_shared<BaseShape>(createTetrahedronMesh(80))), ofVec3f(0, 0, 0), ofVec3f(0, -40, 0), ofVec3f(1, 1, 1));
+	addGeom(SHAPE(make_shared<BaseShape>(createTetrahedronMesh(80))), ofVec3f(0, 0, 0), ofVec3f(40, 0, 0), ofVec3f(1, 1, 1));
+    addGeom(SHAPE(make_shared<BaseShape>(createTetrahedronMesh(120))), ofVec3f(0, 0, 0), ofVec3f(20, 0, 0), ofVec3f(1, 1, 1));
+    addGeom(SHAPE(make_shared<BaseShape>(createTetrahedronMesh(120))), ofVec3f(0, 0, 0), ofVec3f(0, -40, 0), ofVec3f(1, 1, 1));
 
     // Legs
-    addGeom(make_shared<Leg>(4, 3), ofVec3f(1, 1, 0), ofVec3f(0, 0, 0), ofVec3f(1, 1, 1));
-    addGeom(make_shared<Leg>(4, 6), ofVec3f(0, 0, 0), ofVec3f(0, 0, 0), ofVec3f(1, 1, 1));
-    addGeom(make_shared<Leg>(5, 3), ofVec3f(0, 0, PI / 2), ofVec3f(0, 0, 0), ofVec3f(1, 1, 1));
-    addGeom(make_shared<Leg>(6, 4), ofVec3f(0, -(PI / 2), 0), ofVec3f(0, 0, 0), ofVec3f(1, 1, 1));
-    addGeom(make_shared<Leg>(7, 3), ofVec3f(0, PI / 2, PI / 2), ofVec3f(0, 0, 0), ofVec3f(1, 1, 1));
-    addGeom(make_shared<Leg>(8, 5), ofVec3f(0, 1, 0), ofVec3f(0, 0, 0), ofVec3f(1, 1, 1));
-    addGeom(make_shared<Leg>(9, 2), ofVec3f(0, 0, 0), ofVec3f(0, 0, 0), ofVec3f(1, 1, 1));
-    addGeom(make_shared<Leg>(10, 6), ofVec3f(0, 0, PI / 2), ofVec3f(0, 0, 0), ofVec3f(1, 1, 1));
+    addGeom(SHAPE(make_shared<Leg>(4, 3)), ofVec3f(1, 1, 0), ofVec3f(0, 0, 0), ofVec3f(1, 1, 1));
+    addGeom(SHAPE(make_shared<Leg>(4, 6)), ofVec3f(0, 0, 0), ofVec3f(0, 0, 0), ofVec3f(1, 1, 1));
+    addGeom(SHAPE(make_shared<Leg>(5, 3)), ofVec3f(0, 0, PI / 2), ofVec3f(0, 0, 0), ofVec3f(1, 1, 1));
+    addGeom(SHAPE(make_shared<Leg>(6, 4)), ofVec3f(0, -(PI / 2), 0), ofVec3f(0, 0, 0), ofVec3f(1, 1, 1));
+    addGeom(SHAPE(make_shared<Leg>(7, 3)), ofVec3f(0, PI / 2, PI / 2), ofVec3f(0, 0, 0), ofVec3f(1, 1, 1));
+    addGeom(SHAPE(make_shared<Leg>(8, 5)), ofVec3f(0, 1, 0), ofVec3f(0, 0, 0), ofVec3f(1, 1, 1));
+    addGeom(SHAPE(make_shared<Leg>(9, 2)), ofVec3f(0, 0, 0), ofVec3f(0, 0, 0), ofVec3f(1, 1, 1));
+    addGeom(SHAPE(make_shared<Leg>(10, 6)), ofVec3f(0, 0, PI / 2), ofVec3f(0, 0, 0), ofVec3f(1, 1, 1));
 
 	// Antennas
-	addGeom(make_shared<Antenna>(4), ofVec3f(0, -(PI/2), 0), ofVec3f(0,0,0), ofVec3f(1,1,1));
-	addGeom(make_shared<Antenna>(5), ofVec3f(0, 0, 0), ofVec3f(0,0,0), ofVec3f(1,1,1));
-	addGeom(make_shared<Antenna>(6), ofVec3f(0, PI/2, 0), ofVec3f(0,0,0), ofVec3f(1,1,1));
-	addGeom(make_shared<Antenna>(7), ofVec3f( PI/2, -PI/2, 0), ofVec3f(0,0,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<Antenna>(4)), ofVec3f(0, -(PI/2), 0), ofVec3f(0,0,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<Antenna>(5)), ofVec3f(0, 0, 0), ofVec3f(0,0,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<Antenna>(6)), ofVec3f(0, PI/2, 0), ofVec3f(0,0,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<Antenna>(7)), ofVec3f( PI/2, -PI/2, 0), ofVec3f(0,0,0), ofVec3f(1,1,1));
 
 	// Doughnuts
-	addGeom(make_shared<BaseShape>(createTorusMesh(70, 7, 4, 10)), ofVec3f(0,0,0), ofVec3f(0,20,0), ofVec3f(1,1,1));
-	addGeom(make_shared<BaseShape>(createTorusMesh(70, 7, 4, 10)), ofVec3f(0,0,0), ofVec3f(40,0,0), ofVec3f(1,1,1));
-	addGeom(make_shared<BaseShape>(createTorusMesh(70, 7, 10, 10)), ofVec3f(0,0,0), ofVec3f(20,10,0), ofVec3f(1,1,1));
-	addGeom(make_shared<BaseShape>(createTorusMesh(70, 5, 4, 3)), ofVec3f(0,0,0), ofVec3f(40,0,0), ofVec3f(1,1,1));
-	addGeom(make_shared<BaseShape>(createTorusMesh(70, 5, 4, 5)), ofVec3f(0,0,0), ofVec3f(40,0,0), ofVec3f(1,1,1));
-	addGeom(make_shared<BaseShape>(createTorusMesh(70, 2, 4, 10)), ofVec3f(0,0,0), ofVec3f(40,0,0), ofVec3f(1,1,1));
-	addGeom(make_shared<BaseShape>(createTorusMesh(70, 4, 4, 10)), ofVec3f(0,0,0), ofVec3f(40,0,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<BaseShape>(createTorusMesh(70, 7, 4, 10))), ofVec3f(0,0,0), ofVec3f(0,20,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<BaseShape>(createTorusMesh(70, 7, 4, 10))), ofVec3f(0,0,0), ofVec3f(40,0,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<BaseShape>(createTorusMesh(70, 7, 10, 10))), ofVec3f(0,0,0), ofVec3f(20,10,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<BaseShape>(createTorusMesh(70, 5, 4, 3))), ofVec3f(0,0,0), ofVec3f(40,0,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<BaseShape>(createTorusMesh(70, 5, 4, 5))), ofVec3f(0,0,0), ofVec3f(40,0,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<BaseShape>(createTorusMesh(70, 2, 4, 10))), ofVec3f(0,0,0), ofVec3f(40,0,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<BaseShape>(createTorusMesh(70, 4, 4, 10))), ofVec3f(0,0,0), ofVec3f(40,0,0), ofVec3f(1,1,1));
 
 	// Mineral Horns
-	addGeom(make_shared<Minerals>(createCylinderMesh(3, 10, 20, 3, 1)), ofVec3f(1,0,0), ofVec3f(0,20,0), ofVec3f(1,1,1));
-	addGeom(make_shared<Minerals>(createCylinderMesh(3, 10, 20, 3, 1)), ofVec3f(1,1,-PI/2), ofVec3f(20,0,0), ofVec3f(1,1,1));
-	addGeom(make_shared<Minerals>(createCylinderMesh(3, 10, 20, 3, 1)), ofVec3f(1,0,PI/2), ofVec3f(40,0,0), ofVec3f(1,1,1));
-	addGeom(make_shared<Minerals>(createCylinderMesh(3, 10, 20, 3, 1)), ofVec3f(0,1,0), ofVec3f(50,0,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<Minerals>(createCylinderMesh(3, 10, 20, 3, 1))), ofVec3f(1,0,0), ofVec3f(0,20,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<Minerals>(createCylinderMesh(3, 10, 20, 3, 1))), ofVec3f(1,1,-PI/2), ofVec3f(20,0,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<Minerals>(createCylinderMesh(3, 10, 20, 3, 1))), ofVec3f(1,0,PI/2), ofVec3f(40,0,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<Minerals>(createCylinderMesh(3, 10, 20, 3, 1))), ofVec3f(0,1,0), ofVec3f(50,0,0), ofVec3f(1,1,1));
 
 	// Mineral Lines
-	addGeom(make_shared<Minerals>(createCylinderMesh(3, 3, 300, 3, 1)), ofVec3f(0,0,0), ofVec3f(0,20,0), ofVec3f(1,1,1));
-	addGeom(make_shared<Minerals>(createCylinderMesh(3, 3, 300, 3, 1)), ofVec3f(0,0,-PI/2), ofVec3f(20,0,0), ofVec3f(1,1,1));
-	addGeom(make_shared<Minerals>(createCylinderMesh(3, 3, 300, 3, 1)), ofVec3f(0,0,PI/2), ofVec3f(30,0,0), ofVec3f(1,1,1));
-	addGeom(make_shared<Minerals>(createCylinderMesh(3, 3, 300, 3, 1)), ofVec3f(0,0,0), ofVec3f(40,0,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<Minerals>(createCylinderMesh(3, 3, 300, 3, 1))), ofVec3f(0,0,0), ofVec3f(0,20,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<Minerals>(createCylinderMesh(3, 3, 300, 3, 1))), ofVec3f(0,0,-PI/2), ofVec3f(20,0,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<Minerals>(createCylinderMesh(3, 3, 300, 3, 1))), ofVec3f(0,0,PI/2), ofVec3f(30,0,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<Minerals>(createCylinderMesh(3, 3, 300, 3, 1))), ofVec3f(0,0,0), ofVec3f(40,0,0), ofVec3f(1,1,1));
 	
 	// Spikes 
-	addGeom(make_shared<BaseShape>(createCylinderMesh(0, 6, 120, 5, 10)), ofVec3f(-PI/2, 0, 0), ofVec3f(0,0,-30), ofVec3f(1.5, 0.7, 1));
-	addGeom(make_shared<BaseShape>(createCylinderMesh(0, 6, 120, 5, 10)), ofVec3f(-PI/2, 0, 0), ofVec3f(0,0,-30), ofVec3f(1,1,1));
-	addGeom(make_shared<BaseShape>(createCylinderMesh(0, 6, 120, 5, 10)), ofVec3f(-PI/2, 0, 0), ofVec3f(20,20,0), ofVec3f(1,1,1));
-	addGeom(make_shared<BaseShape>(createCylinderMesh(0, 6, 140, 4, 10)), ofVec3f(0, 0, 0), ofVec3f(0,0,0), ofVec3f(1,1,1));
-	addGeom(make_shared<BaseShape>(createCylinderMesh(0, 6, 140, 4, 10)), ofVec3f(0, -PI/2, 0), ofVec3f(0,0,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<BaseShape>(createCylinderMesh(0, 6, 120, 5, 10))), ofVec3f(-PI/2, 0, 0), ofVec3f(0,0,-30), ofVec3f(1.5, 0.7, 1));
+	addGeom(SHAPE(make_shared<BaseShape>(createCylinderMesh(0, 6, 120, 5, 10))), ofVec3f(-PI/2, 0, 0), ofVec3f(0,0,-30), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<BaseShape>(createCylinderMesh(0, 6, 120, 5, 10))), ofVec3f(-PI/2, 0, 0), ofVec3f(20,20,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<BaseShape>(createCylinderMesh(0, 6, 140, 4, 10))), ofVec3f(0, 0, 0), ofVec3f(0,0,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<BaseShape>(createCylinderMesh(0, 6, 140, 4, 10))), ofVec3f(0, -PI/2, 0), ofVec3f(0,0,0), ofVec3f(1,1,1));
 
 	// Long Lines
-	addGeom(make_shared<TentacleStraight>(), ofVec3f(0,0,0), ofVec3f(0,0,0), ofVec3f(1,1,1));
-	addGeom(make_shared<TentacleStraight>(), ofVec3f(0,-PI/2,0), ofVec3f(0,0,0), ofVec3f(1,1,1));
-	addGeom(make_shared<TentacleStraight>(), ofVec3f(0,PI/2,0), ofVec3f(0,0,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<TentacleStraight>()), ofVec3f(0,0,0), ofVec3f(0,0,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<TentacleStraight>()), ofVec3f(0,-PI/2,0), ofVec3f(0,0,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<TentacleStraight>()), ofVec3f(0,PI/2,0), ofVec3f(0,0,0), ofVec3f(1,1,1));
 
 	// Pretzels 
-	addGeom(make_shared<BaseShape>(createTorusKnotMesh(15, 3, 3, 13)), ofVec3f(0, PI/2, 0), ofVec3f(0,0,0), ofVec3f(1,1,1));
-	addGeom(make_shared<BaseShape>(createTorusKnotMesh(15, 3, 3, 10)), ofVec3f(0, 0, 0), ofVec3f(0,0,0), ofVec3f(1,1,1));
-	addGeom(make_shared<BaseShape>(createTorusKnotMesh(15, 3, 3, 6)), ofVec3f(0, 0, 0), ofVec3f(0,0,0), ofVec3f(1,1,1));
-	addGeom(make_shared<BaseShape>(createTorusKnotMesh(15, 3, 3, 13)), ofVec3f(0, 0, 0), ofVec3f(0,0,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<BaseShape>(createTorusKnotMesh(15, 3, 3, 13))), ofVec3f(0, PI/2, 0), ofVec3f(0,0,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<BaseShape>(createTorusKnotMesh(15, 3, 3, 10))), ofVec3f(0, 0, 0), ofVec3f(0,0,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<BaseShape>(createTorusKnotMesh(15, 3, 3, 6))), ofVec3f(0, 0, 0), ofVec3f(0,0,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<BaseShape>(createTorusKnotMesh(15, 3, 3, 13))), ofVec3f(0, 0, 0), ofVec3f(0,0,0), ofVec3f(1,1,1));
 
 	// Cinder Blocks
-	addGeom(make_shared<BaseShape>(createCylinderMesh(12, 7, 80, 4, 10)), ofVec3f(0, 0, 0), ofVec3f(0,0,0), ofVec3f(1,1,1));
-	addGeom(make_shared<BaseShape>(createCylinderMesh(12, 7, 80, 4, 10)), ofVec3f(0, 0, PI/2), ofVec3f(0,0,0), ofVec3f(1,1,1));
-	addGeom(make_shared<BaseShape>(createCylinderMesh(3, 10, 80, 4, 10)), ofVec3f(0, 0, 0), ofVec3f(0,20,0), ofVec3f(1,1,1));
-	addGeom(make_shared<BaseShape>(createCylinderMesh(12, 6, 80, 4, 10)), ofVec3f(0, 0, 0), ofVec3f(0,20,0), ofVec3f(1,1,1));
-	addGeom(make_shared<BaseShape>(createCylinderMesh(12, 10, 80, 4, 10)), ofVec3f(0, 0, 0), ofVec3f(0,-40,30), ofVec3f(1,1,1));
-	addGeom(make_shared<BaseShape>(createCylinderMesh(3, 10, 80, 4, 10)), ofVec3f(0, 0, 0), ofVec3f(0,20,0), ofVec3f(1,1,1));
-	addGeom(make_shared<BaseShape>(createCylinderMesh(12, 6, 80, 4, 10)), ofVec3f(0, 0, 0), ofVec3f(0,20,0), ofVec3f(1,1,1));
-	addGeom(make_shared<BaseShape>(createCylinderMesh(12, 10, 80, 4, 10)), ofVec3f(0, 0, 0), ofVec3f(0,-40,30), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<BaseShape>(createCylinderMesh(12, 7, 80, 4, 10))), ofVec3f(0, 0, 0), ofVec3f(0,0,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<BaseShape>(createCylinderMesh(12, 7, 80, 4, 10))), ofVec3f(0, 0, PI/2), ofVec3f(0,0,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<BaseShape>(createCylinderMesh(3, 10, 80, 4, 10))), ofVec3f(0, 0, 0), ofVec3f(0,20,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<BaseShape>(createCylinderMesh(12, 6, 80, 4, 10))), ofVec3f(0, 0, 0), ofVec3f(0,20,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<BaseShape>(createCylinderMesh(12, 10, 80, 4, 10))), ofVec3f(0, 0, 0), ofVec3f(0,-40,30), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<BaseShape>(createCylinderMesh(3, 10, 80, 4, 10))), ofVec3f(0, 0, 0), ofVec3f(0,20,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<BaseShape>(createCylinderMesh(12, 6, 80, 4, 10))), ofVec3f(0, 0, 0), ofVec3f(0,20,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<BaseShape>(createCylinderMesh(12, 10, 80, 4, 10))), ofVec3f(0, 0, 0), ofVec3f(0,-40,30), ofVec3f(1,1,1));
 
 	// Pettles
-	addGeom(make_shared<Pettle>(), ofVec3f(0,0,0), ofVec3f(30,0,0), ofVec3f(1,1,1));
-	addGeom(make_shared<Pettle>(), ofVec3f(0,PI/2,0), ofVec3f(30,0,0), ofVec3f(1,1,1));
-	addGeom(make_shared<Pettle>(), ofVec3f(0,-PI/2,0), ofVec3f(30,0,0), ofVec3f(1,1,1));
-	addGeom(make_shared<BaseShape>(createCircleMesh(20, 30)), ofVec3f(0,0,0), ofVec3f(40,0,0), ofVec3f(1,1,1));
-	addGeom(make_shared<BaseShape>(createCircleMesh(20, 30)), ofVec3f(0,0,0), ofVec3f(0,-30,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<Pettle>()), ofVec3f(0,0,0), ofVec3f(30,0,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<Pettle>()), ofVec3f(0,PI/2,0), ofVec3f(30,0,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<Pettle>()), ofVec3f(0,-PI/2,0), ofVec3f(30,0,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<BaseShape>(createCircleMesh(20, 30))), ofVec3f(0,0,0), ofVec3f(40,0,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<BaseShape>(createCircleMesh(20, 30))), ofVec3f(0,0,0), ofVec3f(0,-30,0), ofVec3f(1,1,1));
 
 	// Triangles
-	addGeom(make_shared<BaseShape>(createTetrahedronMesh(6)), ofVec3f(0,0,0), ofVec3f(30,0,0), ofVec3f(1,1,1));
-	addGeom(make_shared<BaseShape>(createTetrahedronMesh(6)), ofVec3f(-PI/2,0,0), ofVec3f(30,0,0), ofVec3f(1,1,1));
-	addGeom(make_shared<BaseShape>(createTetrahedronMesh(6)), ofVec3f(0,PI/2,0), ofVec3f(30,0,0), ofVec3f(1,1,1));
-	addGeom(make_shared<BaseShape>(createTetrahedronMesh(6)), ofVec3f(0,-PI/2,0), ofVec3f(30,0,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<BaseShape>(createTetrahedronMesh(6))), ofVec3f(0,0,0), ofVec3f(30,0,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<BaseShape>(createTetrahedronMesh(6))), ofVec3f(-PI/2,0,0), ofVec3f(30,0,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<BaseShape>(createTetrahedronMesh(6))), ofVec3f(0,PI/2,0), ofVec3f(30,0,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<BaseShape>(createTetrahedronMesh(6))), ofVec3f(0,-PI/2,0), ofVec3f(30,0,0), ofVec3f(1,1,1));
 
 	// Squares ?? 
-	addGeom(make_shared<BaseShape>(createCylinderMesh(5, 5, 7, 4, 1)), ofVec3f(0,0,0), ofVec3f(30,0,0), ofVec3f(1,1,1));
-	addGeom(make_shared<BaseShape>(createCylinderMesh(5, 5, 7, 4, 1)), ofVec3f(-PI/2,0,0), ofVec3f(30,0,0), ofVec3f(1,1,1));
-	addGeom(make_shared<BaseShape>(createCylinderMesh(5, 5, 7, 4, 1)), ofVec3f(0,PI/2,0), ofVec3f(30,0,0), ofVec3f(1,1,1));
-	addGeom(make_shared<BaseShape>(createCylinderMesh(5, 5, 7, 4, 1)), ofVec3f(0,-PI/2,0), ofVec3f(30,0,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<BaseShape>(createCylinderMesh(5, 5, 7, 4, 1))), ofVec3f(0,0,0), ofVec3f(30,0,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<BaseShape>(createCylinderMesh(5, 5, 7, 4, 1))), ofVec3f(-PI/2,0,0), ofVec3f(30,0,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<BaseShape>(createCylinderMesh(5, 5, 7, 4, 1))), ofVec3f(0,PI/2,0), ofVec3f(30,0,0), ofVec3f(1,1,1));
+	addGeom(SHAPE(make_shared<BaseShape>(createCylinderMesh(5, 5, 7, 4, 1))), ofVec3f(0,-PI/2,0), ofVec3f(30,0,0), ofVec3f(1,1,1));
 
 	// Bubbles
-	addGeom(make_shared<BaseShape>(ofMesh::sphere(5, 5)), ofVec3f(0, 0, 0), ofVec3f(30, 0, 0), ofVec3f(1, 1, 1));
-	addGeom(make_shared<BaseShape>(ofMesh::sphere(5, 5)), ofVec3f(-PI / 2, 0, 0), ofVec3f(30, 0, 0), ofVec3f(1, 1, 1));
-	addGeom(make_shared<BaseShape>(ofMesh::sphere(5, 5)), ofVec3f(0, PI / 2, 0), ofVec3f(30, 0, 0), ofVec3f(1, 1, 1));
-	addGeom(make_shared<BaseShape>(ofMesh::sphere(5, 5)), ofVec3f(0, -PI / 2, 0), ofVec3f(30, 0, 0), ofVec3f(1, 1, 1));
+	addGeom(SHAPE(make_shared<BaseShape>(ofMesh::sphere(5, 5))), ofVec3f(0, 0, 0), ofVec3f(30, 0, 0), ofVec3f(1, 1, 1));
+	addGeom(SHAPE(make_shared<BaseShape>(ofMesh::sphere(5, 5))), ofVec3f(-PI / 2, 0, 0), ofVec3f(30, 0, 0), ofVec3f(1, 1, 1));
+	addGeom(SHAPE(make_shared<BaseShape>(ofMesh::sphere(5, 5))), ofVec3f(0, PI / 2, 0), ofVec3f(30, 0, 0), ofVec3f(1, 1, 1));
+	addGeom(SHAPE(make_shared<BaseShape>(ofMesh::sphere(5, 5))), ofVec3f(0, -PI / 2, 0), ofVec3f(30, 0, 0), ofVec3f(1, 1, 1));
 }
 
-void ofApp::createPregeom(ofMesh& geometry, float size, const ofMesh& pregeom, int type) {
+void ofApp::createPregeom(Scene& scene, float size, int shapeIndex, const vector<float>& fftValues) {
+    const ofMesh& pregeom = precomputedGeometries.at(shapeIndex).mesh;
+
     float fileScale = size / 300000.0f;
     float fileScaleOrg = fileScale;
 
@@ -405,12 +464,12 @@ void ofApp::createPregeom(ofMesh& geometry, float size, const ofMesh& pregeom, i
         fileScale = 1.0f;
     }
 
-    vector<float> fftValues = fft.getBins(); // Get the current FFT values
     int fftSize = fftValues.size();
 
     for (int k = 0; k < fileScale * 4; ++k) {
-        // Copy the precomputed mesh
+        // Copy the precomputed mesh, the scene's color comes from the material
         ofMesh submesh = pregeom;
+        submesh.clearColors();
 
         // Create transformation matrix
         ofMatrix4x4 transformMatrix;
@@ -454,74 +513,43 @@ void ofApp::createPregeom(ofMesh& geometry, float size, const ofMesh& pregeom, i
             vertex.z = homogenousVertex.z;
         }
 
-        submeshes.push_back(std::make_pair(size, submesh));
-        geometry.append(submesh);
+        Submesh entry;
+        entry.shapeIndex = shapeIndex;
+        entry.size = size;
+        entry.fileScale = deform::fileScaleForSize(entry.size);
+        // ofMatrix4x4 is row-major and postMult multiplies rows, glm wants the transpose
+        entry.transform = glm::transpose(glm::mat4(transformMatrix));
+        entry.vertexOffset = scene.geometry.getNumVertices();
+        entry.positions.resize(submesh.getNumVertices());
+        for (int i = 0; i < submesh.getNumVertices(); ++i) {
+            const auto& vertex = submesh.getVertices()[i];
+            entry.positions.x[i] = vertex.x;
+            entry.positions.y[i] = vertex.y;
+            entry.positions.z[i] = vertex.z;
+        }
+        scene.submeshes.push_back(std::move(entry));
+        scene.geometry.append(submesh);
     }
 }
 
-void ofApp::updatePregeom(ofMesh& geometry, float size, const ofMesh& pregeom, int type) {
-    float fileScale = size / 300000.0f;
-    float fileScaleOrg = fileScale;
-
-    if (fileScale < 0.4f) {
-        fileScale = 0.4f;
-    }
-    if (fileScale > 1.0f) {
-        fileScale = 1.0f;
-    }
-
-    vector<float> fftValues = fft.getBins(); // Get the current FFT values
-    int fftSize = fftValues.size();
-
-    // Copy the precomputed mesh
-    ofMesh submesh = pregeom;
-
-    // Create transformation matrix
-    ofMatrix4x4 transformMatrix;
-
-    // Iterate over the vertices of the submesh
-    for (int i = 0; i < submesh.getNumVertices(); ++i) {
-        // Map the vertex index to the FFT spectrum
-        int fftIndex = ofMap(i, 0, submesh.getNumVertices(), 0, fftSize - 1, true);
-        fftIndex = ofClamp(fftIndex, 0, fftSize - 1);
-        float fftValue = fftSize == 0 ? 1 : fftValues[fftIndex] * AUDIO_SCALING;
-
-        float scaleValue = fileScale * (1.0 + fftValue * 0.1);
-        ofMatrix4x4 vertexTransformMatrix;
-        vertexTransformMatrix.scale(scaleValue, scaleValue, scaleValue);
-
-        // Apply translation using FFT values
-        float randoms2[3] = {
-            sin((2 + i) * fileScaleOrg * 413.0f + 0.1f) / 2.0f + 0.5f + fftValue * 0.1f,
-            sin((2 + i) * fileScaleOrg * 543.0f + 0.2f) / 2.0f + 0.5f + fftValue * 0.1f,
-            sin((2 + i) * fileScaleOrg * 123.0f + 0.3f) / 2.0f + 0.5f + fftValue * 0.1f
-        };
+// Deforms vertices [begin, end) of submesh into its slice of the frame mesh.
+// Runs on the thread pool, tasks only ever write their own range.
+void ofApp::updatePregeom(glm::vec3* vertices, const Submesh& submesh, deform::Params params,
+                          deform::Span deformed, size_t begin, size_t end) {
+    params.fileScale = submesh.fileScale;
 
-        vertexTransformMatrix.translate(
-            (randoms2[1] - 0.5f) * 100.0f * fileScale,
-            (randoms2[0] - 0.5f) * 100.0f * fileScale,
-            (randoms2[2] - 0.5f) * 100.0f * fileScale
-        );
+    // Scale every vertex by its FFT bin, see DeformKernel.h
+    deform::scaleSimd(submesh.positions, deformed, params, begin, end);
 
-        // Apply the transformation to the vertex
-        ofVec4f homogenousVertex = ofVec4f(submesh.getVertices()[i].x, submesh.getVertices()[i].y, submesh.getVertices()[i].z, 1.0);
-        homogenousVertex = vertexTransformMatrix.postMult(homogenousVertex);
-        submesh.getVertices()[i].x = homogenousVertex.x;
-        submesh.getVertices()[i].y = homogenousVertex.y;
-        submesh.getVertices()[i].z = homogenousVertex.z;
+    glm::vec3* out = vertices + submesh.vertexOffset;
+    for (size_t i = begin; i < end; ++i) {
+        out[i] = glm::vec3(deformed.x[i], deformed.y[i], deformed.z[i]);
     }
-
-    // Merge the transformed submesh into the main geometry
-    geometry.append(submesh);
 }
 
-
-
-void ofApp::addGeom(shared_ptr<BaseShape> geom, const ofVec3f& rotation, const ofVec3f& translation, const ofVec3f& scale) {
-    geom->applyScale(scale);
-    geom->applyRotation(rotation);
-    geom->applyTranslation(translation);
-    precomputedGeometries.push_back(geom);
+void ofApp::addGeom(const std::string& key, const std::function<shared_ptr<BaseShape>()>& generate,
+                    const ofVec3f& rotation, const ofVec3f& translation, const ofVec3f& scale) {
+    shapeRecipes.push_back({key, generate, rotation, translation, scale});
 }
 
 int ofApp::getRandomShapeIndex() {
@@ -533,14 +561,47 @@ int ofApp::getRandomShapeIndex() {
     }
 }
 
-void applyUniformColor(ofMesh& mesh, const ofColor& color) {
-    mesh.clearColors(); 
-    for (int i = 0; i < mesh.getNumVertices(); ++i) {
-        mesh.addColor(color); 
+// CPU path, deforms the scene's mesh in place for the current bands, one
+// thread pool task per deformRanges entry. The deform scratch comes from
+// frameArena, so once the arena has grown to fit the scene this doesn't
+// touch the heap.
+void ofApp::rebuildGeometry() {
+    frameArena.reset();
+    for (size_t i = 0; i < submeshes.size(); ++i) {
+        size_t numVertices = submeshes[i].positions.size();
+        deformScratch[i] = {
+            frameArena.allocate<float>(numVertices),
+            frameArena.allocate<float>(numVertices),
+            frameArena.allocate<float>(numVertices)
+        };
+    }
+
+    const vector<float>& fftValues = analyzer.getBands();
+    deform::Params params;
+    params.bins = fftValues.data();
+    params.numBins = fftValues.size();
+    params.audioScaling = AUDIO_SCALING;
+
+    glm::vec3* vertices = frameShape->mesh.getVerticesPointer();
+    std::thread::id caller = std::this_thread::get_id();
+    std::atomic<uint64_t> workerAllocations{0};
+    {
+        PROFILE_SCOPE("updatePregeom");
+        threadPool.parallelFor(deformRanges.size(), [&](size_t i) {
+            const DeformRange& range = deformRanges[i];
+            uint64_t allocationsBefore = alloccount::threadAllocations;
+            updatePregeom(vertices, submeshes[range.submesh], params, deformScratch[range.submesh], range.begin, range.end);
+            // The calling thread's own tasks are already in its counter
+            if (std::this_thread::get_id() != caller) {
+                workerAllocations += alloccount::threadAllocations - allocationsBefore;
+            }
+        });
     }
+    deformWorkerAllocations = workerAllocations;
+    shapeToRender = frameShape;
 }
 
-void ofApp::setupGeometry() {
+void ofApp::setupGeometry(Scene& scene, const vector<float>& fftValues) {
     std::vector<ofColor> colors = {
         ofColor::fromHex(0x00AA00), 
         ofColor::fromHex(0x55FF55), 
@@ -548,26 +609,144 @@ void ofApp::setupGeometry() {
         ofColor::fromHex(0x00AAAA),
         ofColor::fromHex(0xAA00AA)
     };
-    currentColor = colors[static_cast<int>(ofRandom(0, colors.size()))];
-    ofMesh complexGeometry;
+    scene.color = colors[static_cast<int>(ofRandom(0, colors.size()))];
+
+    createPregeom(scene, 1054600, getRandomShapeIndex(), fftValues);
+	createPregeom(scene, 3945123, getRandomShapeIndex(), fftValues);
+    createPregeom(scene, 150000, getRandomShapeIndex(), fftValues);
+    createPregeom(scene, 1502, getRandomShapeIndex(), fftValues);
+}
+
+// Runs on the SceneBuilder thread, must not touch GL or the current scene
+void ofApp::buildScene(Scene& scene, const vector<float>& fftValues) {
+    PROFILE_SCOPE("buildScene");
+    setupGeometry(scene, fftValues);
+}
 
-    createPregeom(complexGeometry, 1054600, precomputedGeometries[getRandomShapeIndex()]->mesh, 2);
-	createPregeom(complexGeometry, 3945123, precomputedGeometries[getRandomShapeIndex()]->mesh, 3);
-    createPregeom(complexGeometry, 150000, precomputedGeometries[getRandomShapeIndex()]->mesh, 4);
-    createPregeom(complexGeometry, 1502, precomputedGeometries[getRandomShapeIndex()]->mesh, 4);
+// Takes over the scene's CPU side data, its combined mesh becomes the one
+// rebuildGeometry() deforms in place
+void ofApp::applySceneGeometry(Scene& scene) {
+    submeshes = std::move(scene.submeshes);
+    currentColor = scene.color;
+    frameShape = make_shared<BaseShape>();
+    frameShape->mesh = std::move(scene.geometry);
+    frameShape->material = material;
+    frameShape->setColor(currentColor);
+
+    // The scene's topology is fixed, so its split into tasks is too
+    deformRanges.clear();
+    for (size_t i = 0; i < submeshes.size(); ++i) {
+        size_t numVertices = submeshes[i].positions.size();
+        for (size_t begin = 0; begin < numVertices; begin += DEFORM_RANGE_VERTICES) {
+            deformRanges.push_back({i, begin, std::min(begin + DEFORM_RANGE_VERTICES, numVertices)});
+        }
+    }
+    deformScratch.resize(submeshes.size());
+}
+
+// Makes a built scene current, called between frames on the render thread
+void ofApp::applyScene(Scene& scene) {
+    applySceneGeometry(scene);
+
+    // One instanced batch per distinct shape. Base meshes are uploaded the
+    // first time a scene uses them and kept, the library never changes.
+    std::map<int, vector<DeformShape::Instance>> instances;
+    submeshVertexCount = 0;
+    for (auto& submesh : submeshes) {
+        instances[submesh.shapeIndex].push_back({submesh.transform, submesh.fileScale});
+        submeshVertexCount += submesh.positions.size();
+    }
 
-    applyUniformColor(complexGeometry, currentColor);
-    shapeToRender = make_shared<BaseShape>(complexGeometry);
+    deformShape = make_shared<DeformShape>();
+    size_t uploadedVertices = 0;
+    for (auto& batch : instances) {
+        shared_ptr<GpuMesh>& gpuMesh = gpuMeshes[batch.first];
+        if (!gpuMesh) {
+            gpuMesh = make_shared<GpuMesh>();
+            gpuMesh->setup(precomputedGeometries.at(batch.first).mesh);
+            uploadedVertices += gpuMesh->numVertices;
+        }
+        deformShape->addBatch(gpuMesh, batch.second);
+    }
+    deformShape->shader = &deformShader;
+    deformShape->spectrum = &analyzer.getBands();
+    deformShape->audioScaling = AUDIO_SCALING;
+    deformShape->setColor(currentColor);
+
+    trigEvaluationsSavedPerFrame = 3 * submeshVertexCount;
+    ofLogNotice() << submeshVertexCount << " submesh vertices, " << trigEvaluationsSavedPerFrame << " sin() calls per frame skipped";
+    ofLogNotice() << submeshes.size() << " instances of " << instances.size() << " shapes, "
+                  << uploadedVertices << " new vertices uploaded, " << gpuMeshes.size() << " shapes resident";
+
+    if (gpuDeform) {
+        shapeToRender = deformShape;
+    } else {
+        shapeToRender = frameShape;
+    }
+}
+
+// The analyzer's front buffer changes with every update(), point the shader at the current one
+void ofApp::uploadSpectrum() {
+    deformShape->spectrum = &analyzer.getBands();
+}
+
+// mirror, if given, is applied to the shape's model matrix in world space
+void ofApp::drawShape(const glm::mat4* mirror) {
+    pointLight.enable();
+    if (gpuDeform) {
+        // an active ofMaterial would replace the deform shader, so light it in the shader instead
+        deformShape->lightPosition = glm::vec3(ofGetCurrentViewMatrix() * glm::vec4(pointLight.getGlobalPosition(), 1.0f));
+    }
+    if (mirror) {
+        shapeToRender->drawMirrored(*mirror);
+    } else {
+        shapeToRender->draw();
+    }
+    pointLight.disable();
 }
 
 //--------------------------------------------------------------
 void ofApp::setup() {
     ofDisableArbTex();
     ofBackground(0);
-    ofSetFullscreen(true);
-	generateGeometries();
-    loadNextTextures();
-    setupGeometry();
+    if (!offlineRender.enabled()) {
+        ofSetFullscreen(true);
+    }
+    trigEvaluationsSaved = 0;
+    updateAllocations = 0;
+    profiler().setup();
+    showProfiler = false;
+    gpuDeform = DeformShape::loadShader(deformShader);
+    if (!gpuDeform) {
+        ofLogError() << "Deform shader failed to load, deforming on the CPU";
+    }
+
+    // The shape library is built once and shared by every regeneration
+    generateGeometries();
+    precomputedGeometries.freeze();
+    ofLogNotice() << "Shape library: " << precomputedGeometries.size() << " shapes, "
+                  << precomputedGeometries.numVertices() << " vertices, "
+                  << precomputedGeometries.footprintBytes() / 1024 << " KB";
+
+    waterStreamer.setup(waterTextures, "water");
+    skyStreamer.setup(skyTextures, "sky");
+    waterStreamer.loadFirst();
+    skyStreamer.loadFirst();
+
+    // Set up material properties, every scene's shape starts from these
+    material.setShininess(128);
+    material.setSpecularColor(ofColor(255, 255, 255, 255));
+
+    // The first scene is built right away, later ones on the SceneBuilder thread
+    Scene scene;
+    buildScene(scene, analyzer.getBands());
+    applyScene(scene);
+    sceneRequested = false;
+    sceneBuilder.build = [this](Scene& next, const vector<float>& fftValues) {
+        buildScene(next, fftValues);
+    };
+    sceneBuilder.startThread();
+
     // Set up lighting and camera
     ofEnableLighting();
     
@@ -583,9 +762,6 @@ void ofApp::setup() {
     directionalLight.setDirectional();
     directionalLight.setOrientation(ofVec3f(45, 45, 0));
 
-    // Set up material properties
-    material.setShininess(128);
-    material.setSpecularColor(ofColor(255, 255, 255, 255));
     ofEnableDepthTest();
 
     cam.setNearClip(0.1);
@@ -601,10 +777,7 @@ void ofApp::setup() {
     waterPlane.setPosition(0, 800, 0);  
     waterPlane.rotateDeg(90, 1, 0, 0);
     waterPlane.mapTexCoords(0, 0, 1, 1);
-    // set up the sky plane
-    skyPlane.set(ofGetWidth(), ofGetHeight(), 10, 10);
-    skyPlane.setPosition(ofGetWidth() / 2, ofGetHeight() / 2, 0);
-    skyPlane.mapTexCoords(0, 0, 1, 1);
+    skyPass.setup();
 
     // Load the water shader
     if (!waterShader.load("shaders/water/water")) {
@@ -613,101 +786,165 @@ void ofApp::setup() {
         ofLogNotice() << "Shader loaded successfully!";
     }
 
-    // i know i know
-    if (!skyShader.load("shaders/water/water")) {
-        ofLogError() << "Shader failed to load!";
-    } else {
-        ofLogNotice() << "Shader loaded successfully!";
-    }
-
-    // set up the FBO 
-    reflectionFbo.allocate(ofGetWidth(), ofGetHeight(), GL_RGBA);
+    // set up the reflection FBO
+    reflection.setup(ofGetWidth(), ofGetHeight(), reflectionQuality);
 
     ofLogNotice() << "OpenGL Vendor: " << glGetString(GL_VENDOR);
     ofLogNotice() << "OpenGL Renderer: " << glGetString(GL_RENDERER);
     ofLogNotice() << "OpenGL Version: " << glGetString(GL_VERSION);
 
-    // FFT stuff 
-    fft.setup(16384);
+    // FFT stuff
+    static_assert(FFT_BANDS <= DeformShape::MAX_SPECTRUM_SIZE, "deform.vert can't take that many bands");
+    if (offlineRender.enabled()) {
+        setupOfflineRender();
+        return;
+    }
+    analyzer.setup(FFT_WINDOW_SIZE, FFT_HOP_SIZE, FFT_BANDS, FFT_SAMPLE_RATE);
+    ofSoundStreamSettings soundSettings;
+    soundSettings.setInListener(this);
+    soundSettings.sampleRate = FFT_SAMPLE_RATE;
+    soundSettings.numInputChannels = 1;
+    soundSettings.numOutputChannels = 0;
+    soundSettings.bufferSize = 256;
+    soundStream.printDeviceList();
+    soundStream.setup(soundSettings);
+}
+
+// Renders offlineRender.audioPath frame by frame with a fixed timestep, as
+// fast as the GPU and the encoders allow, then exits
+void ofApp::setupOfflineRender() {
+    offlineFrame = 0;
+    offlineFrames = 0;
+    if (!offlineAudio.load(offlineRender.audioPath)) {
+        return;
+    }
+    analyzer.setup(FFT_WINDOW_SIZE, FFT_HOP_SIZE, FFT_BANDS, offlineAudio.sampleRate);
+    offlineFrames = ceil(offlineAudio.getDuration() * offlineRender.fps);
+
+    renderFbo.allocate(ofGetWidth(), ofGetHeight(), GL_RGBA);
+    frameRecorder.setup(ofGetWidth(), ofGetHeight(), offlineRender.outputDir,
+                        offlineRender.raw ? FrameRecorder::RawRgba : FrameRecorder::Png);
+    ofSetVerticalSync(false);
+    ofSetFrameRate(0);
+    offlineStart = ofGetElapsedTimef();
+    ofLogNotice() << "Rendering " << offlineFrames << " frames at " << offlineRender.fps << " fps, "
+                  << ofGetWidth() << "x" << ofGetHeight() << " to " << offlineRender.outputDir;
+}
+
+float ofApp::getFrameTime() {
+    return offlineRender.enabled() ? 1.0f / offlineRender.fps : ofGetLastFrameTime();
 }
 
 void ofApp::draw() {
-    // 1. Render the reflection to the FBO
-    reflectionFbo.begin();
-    ofClear(0, 0, 0, 255);  // Clear the FBO with a black background
+    if (!offlineRender.enabled()) {
+        drawScene();
+        if (showProfiler) {
+            profiler().drawOverlay(16, ofGetHeight() - 200);
+        }
+        return;
+    }
 
-    // Flip the scene vertically for the reflection effect
-    cam.begin();
+    if (offlineFrame >= offlineFrames) {
+        frameRecorder.finish();
+        ofLogNotice() << "Rendered " << offlineFrames << " frames in " << ofGetElapsedTimef() - offlineStart << " s";
+        ofExit();
+        return;
+    }
 
-    // Apply the same rotation as in the main scene, but in the opposite direction for the reflection
-    shapeToRender->applyRotation(ofVec3f(0, -objectRotationAngle, 0));  
-    pointLight.enable();
-    material.begin();
-    shapeToRender->draw();
-    
-    material.end();
-    pointLight.disable();
+    // The readback is queued, the frame is written out a few frames later
+    renderFbo.begin();
+    ofClear(0, 0, 0, 255);
+    drawScene();
+    renderFbo.end();
+    frameRecorder.capture(renderFbo);
+
+    offlineFrame++;
+    if (offlineFrame % 100 == 0) {
+        float elapsed = ofGetElapsedTimef() - offlineStart;
+        ofLogNotice() << "Frame " << offlineFrame << "/" << offlineFrames << ", " << offlineFrame / elapsed << " fps";
+    }
+}
 
-    cam.end();
-    reflectionFbo.end();
+void ofApp::drawScene() {
+    profiler().beginFrame();
 
-    // 2. Render the main scene
-    ofDisableDepthTest();
-    // sky first
-    skyImage.getTexture().bind();
-    skyShader.begin();
-    skyShader.setUniform2f("resolution", ofGetWidth(), ofGetHeight());
-    skyShader.setUniform1i("skyTexture", 0);
-    skyPlane.draw();
-    skyShader.end();
-    skyImage.getTexture().unbind();
-    ofEnableDepthTest();
+    // 1. Render the reflection to the FBO, at reflectionQuality's scale and rate
+    if (reflection.beginFrame()) {
+        PROFILE_GPU_SCOPE("reflection pass");
+        // The camera mirrored about the water, clipped to what is above it
+        reflection.begin(cam, waterPlane.getPosition().y);
+
+        // The light is mirrored with the scene, so the reflection is lit like the original
+        glm::vec3 lightPosition = pointLight.getPosition();
+        pointLight.setPosition(reflection.mirror(lightPosition));
+        shapeToRender->applyRotation(ofVec3f(0, objectRotationAngle, 0));
+        glm::mat4 mirror = reflection.getMirrorMatrix();
+        drawShape(&mirror);
+        pointLight.setPosition(lightPosition);
+
+        reflection.end(cam);
+    }
 
+    // 2. Render the main scene
     // next the water plane (this will render below the shapes)
     cam.begin();
     cam.lookAt(ofVec3f(0, 0, 0), ofVec3f(0, -1, 0));  // Normal camera direction
 
-    // Bind the FBO's texture and pass it to the shader for the water reflection
-    reflectionFbo.getTexture().bind(1);  // Bind FBO texture to texture unit 1
-    waterImage.getTexture().bind(0);     // Bind the water texture to texture unit 0
+    {
+        PROFILE_GPU_SCOPE("water pass");
+        // Bind the FBO's texture and pass it to the shader for the water reflection
+        reflection.getTexture().bind(1);  // Bind FBO texture to texture unit 1
+        waterStreamer.getTexture().bind(0);     // Bind the water texture to texture unit 0
 
-    waterShader.begin();
-    waterShader.setUniform2f("resolution", ofGetWidth(), ofGetHeight());
-    waterShader.setUniform1i("waterTexture", 0);
-    waterShader.setUniform1i("reflectionTexture", 1);  // Pass FBO texture as reflection texture
+        waterShader.begin();
+        waterShader.setUniform2f("resolution", ofGetWidth(), ofGetHeight());
+        waterShader.setUniform1i("waterTexture", 0);
+        waterShader.setUniform1i("reflectionTexture", 1);  // Pass FBO texture as reflection texture
+        waterShader.setUniformMatrix4f("reflectionMatrix", reflection.getTextureMatrix(ofGetCurrentViewMatrix()));
 
-    waterPlane.draw();  // Draw the water plane
+        waterPlane.draw();  // Draw the water plane
 
-    waterShader.end();
+        waterShader.end();
 
-    waterImage.getTexture().unbind();
-    reflectionFbo.getTexture().unbind();
+        waterStreamer.getTexture().unbind();
+        reflection.getTexture().unbind();
+    }
 
     // Now render the shape above the water plane with the original rotation
-    shapeToRender->applyRotation(ofVec3f(0, objectRotationAngle, 0));  
-    pointLight.enable();
-    material.begin();
-    shapeToRender->draw();
-    
-    material.end();
-    pointLight.disable();
+    {
+        PROFILE_GPU_SCOPE("shape pass");
+        shapeToRender->applyRotation(ofVec3f(0, objectRotationAngle, 0));  
+        drawShape();
+    }
 
     cam.end();
 
+    // The sky last, only where the water and the shape left the far plane
+    {
+        PROFILE_GPU_SCOPE("sky pass");
+        skyPass.draw(skyStreamer.getTexture());
+    }
+
     #ifdef DEBUG
         ofPushMatrix();
         ofTranslate(16, 16);
         ofSetColor(255);
         ofDrawBitmapString("Frequency Domain", 0, 0);
-        plot(fft.getBins(), 128);
+        plot(analyzer.getBins(), 128);
         ofPopMatrix();
         
         string msg = ofToString((int) ofGetFrameRate()) + " fps";
         ofDrawBitmapString(msg, ofGetWidth() - 80, ofGetHeight() - 20);
+
+        string trig = "sin() saved: " + ofToString(trigEvaluationsSavedPerFrame) + "/frame, " + ofToString(trigEvaluationsSaved) + " total";
+        ofDrawBitmapString(trig, ofGetWidth() - 400, ofGetHeight() - 40);
+
+        string allocations = "heap allocations in update(): " + ofToString(updateAllocations);
+        ofDrawBitmapString(allocations, ofGetWidth() - 400, ofGetHeight() - 60);
     #endif DEBUG
 }
 
-void ofApp::plot(vector<float>& buffer, float scale) {
+void ofApp::plot(const vector<float>& buffer, float scale) {
 	ofNoFill();
 	int n = MIN(1024, buffer.size());
 	ofDrawRectangle(0, 0, n, scale);
@@ -724,43 +961,97 @@ void ofApp::plot(vector<float>& buffer, float scale) {
 
 //--------------------------------------------------------------
 void ofApp::update(){
+    uint64_t allocationsBefore = alloccount::threadAllocations;
+    deformWorkerAllocations = 0;
     objectRotationAngle += objectRotationSpeed;
     ofVec3f rotation(0, objectRotationAngle, 0);
 
-    ofMesh complexGeometry;
+    // Swap in a finished regeneration at the frame boundary
+    // Offline frames wait for a requested scene, so the output doesn't depend on how long it took to build
+    std::unique_ptr<Scene> nextScene;
+    bool received = offlineRender.enabled() && sceneRequested ? sceneBuilder.receive(nextScene) : sceneBuilder.tryReceive(nextScene);
+    if (received) {
+        applyScene(*nextScene);
+        loadNextTextures();
+        sceneRequested = false;
+    }
+    waterStreamer.update();
+    skyStreamer.update();
+
+    // Offline, analyze exactly this frame's slice of the file
+    if (offlineRender.enabled() && offlineFrame < offlineFrames) {
+        PROFILE_SCOPE("fft analyze");
+        double samplesPerFrame = static_cast<double>(offlineAudio.sampleRate) / offlineRender.fps;
+        size_t begin = static_cast<size_t>(offlineFrame * samplesPerFrame);
+        size_t end = std::min(offlineAudio.samples.size(), static_cast<size_t>((offlineFrame + 1) * samplesPerFrame));
+        if (end > begin) {
+            analyzer.process(&offlineAudio.samples[begin], end - begin);
+        }
+    }
+
+    // Take the newest spectrum from the analysis thread, it stays put for the frame
+    // and both deform paths use it
+    {
+        PROFILE_SCOPE("fft update");
+        analyzer.update();
+    }
 
-    submeshMutex.lock();
-    for (auto &mesh : submeshes) {
-        updatePregeom(complexGeometry, mesh.first, mesh.second, 0);
+    if (!gpuDeform) {
+        rebuildGeometry();
     }
-    submeshMutex.unlock();
-    applyUniformColor(complexGeometry, currentColor);
-    shapeToRender = make_shared<BaseShape>(complexGeometry);
 
     // Apply rotation
     shapeToRender->applyRotation(rotation);
 
-    // Update the FFT data
-    fft.update();
-
-    textureSwapTimer += ofGetLastFrameTime();
-    if(textureSwapTimer >= textureSwapTimeout) {
+    textureSwapTimer += getFrameTime();
+    if(textureSwapTimer >= textureSwapTimeout && !sceneRequested) {
         textureSwapTimer = 0.0f;
-        submeshes.clear();
-        generateGeometries();
-        setupGeometry();
-        loadNextTextures();
+        sceneRequested = true;
+        sceneBuilder.request(analyzer.getBands());
+    }
+
+    if (gpuDeform) {
+        // Geometry stays resident, only the bands go to the GPU
+        uploadSpectrum();
     }
+    trigEvaluationsSaved += trigEvaluationsSavedPerFrame;
+    // This thread's plus what the deform tasks allocated on the pool's workers
+    updateAllocations = alloccount::threadAllocations - allocationsBefore + deformWorkerAllocations;
 }
 
 
 
+void ofApp::exit(){
+    frameRecorder.finish();
+    soundStream.close();
+    analyzer.stop();
+    sceneBuilder.stop();
+    waterStreamer.stop();
+    skyStreamer.stop();
+}
+
 void ofApp::audioIn(ofSoundBuffer & input){
-	
+    analyzer.audioIn(input);
 }
 
 //--------------------------------------------------------------
 void ofApp::keyPressed  (int key){ 
+    if (key == 'p') {
+        showProfiler = !showProfiler;
+    }
+    if (key == 't') {
+        if (profiler().isTracing()) {
+            profiler().stopTrace("trace_" + ofGetTimestampString() + ".json");
+        } else {
+            profiler().startTrace();
+        }
+    }
+    if (key == 'g') {
+        gpuDeform = !gpuDeform && deformShader.isLoaded();
+        if (gpuDeform) {
+            shapeToRender = deformShape;
+        }
+    }
 }
 
 //--------------------------------------------------------------
@@ -800,7 +1091,7 @@ void ofApp::mouseExited(int x, int y){
 
 //--------------------------------------------------------------
 void ofApp::windowResized(int w, int h){
-
+    reflection.resize(w, h);
 }
 
 //--------------------------------------------------------------
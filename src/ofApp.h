@@ -1,23 +1,57 @@
 #pragma once
 
 #include "ofMain.h"
-#include "ofxEasyFft.h"
 #include "Pettle.h"
 #include "Minerals.h"
 #include "Tentacle.h"
 #include "Antenna.h"
 #include "Leg.h"
 #include "TentacleStraight.h"
+#include "DeformShape.h"
+#include "ShapeLibrary.h"
+#include "MeshPack.h"
+#include "MeshOptimize.h"
+#include "ThreadPool.h"
+#include "DeformKernel.h"
+#include "Scene.h"
+#include "SceneBuilder.h"
+#include "TextureStreamer.h"
+#include "AudioAnalyzer.h"
+#include "Profiler.h"
+#include "OfflineRender.h"
+#include "WavFile.h"
+#include "FrameRecorder.h"
+#include "ReflectionPass.h"
+#include "SkyPass.h"
+#include "FrameArena.h"
+#include "AllocationCounter.h"
 #include <memory>
 #include <vector>
 #include <utility>
 
+// Analysis window and hop in samples, 4096/512 is 93 ms of audio refreshed
+// every 12 ms at 44.1 kHz. The geometry sees FFT_BANDS log-spaced bands.
+#define FFT_SAMPLE_RATE 44100
+#define FFT_WINDOW_SIZE 4096
+#define FFT_HOP_SIZE 512
+#define FFT_BANDS 64
+
+// The shape library's mesh cache. Bump the version whenever a create*Mesh
+// function or a shape class changes the meshes it generates.
+#define SHAPE_CACHE_PATH "cache/shapes.pack"
+#define SHAPE_GENERATOR_VERSION 3
+
+// Vertices the CPU path deforms per thread pool task. Big submeshes are
+// split so every core gets work, small ones are a single task.
+#define DEFORM_RANGE_VERTICES 16384
+
 class ofApp : public ofBaseApp{
 	
 	public:
 		void setup();
 		void update();
 		void draw();
+		void exit();
 		
 		void keyPressed(int key);
 		void keyReleased(int key);
@@ -32,47 +66,109 @@ class ofApp : public ofBaseApp{
 		void gotMessage(ofMessage msg);
 				
 		void audioIn(ofSoundBuffer & input);
-		void plot(vector<float>& buffer, float scale);
+		void plot(const vector<float>& buffer, float scale);
 		void applyFFTToGeometry(ofMesh& mesh, const vector<float>& fftValues);
 
-		void generateGeometries();
+		void generateGeometries(bool useCache = true);
+		void generateLibraryShapes();
 		void generateTestGeometries();
-		void setupGeometry();
-		void addGeom(shared_ptr<BaseShape> geom, const ofVec3f& rotation, const ofVec3f& translation, const ofVec3f& scale);
-		void createPregeom(ofMesh& geometry, float size, const ofMesh& pregeom, int type);
-		void updatePregeom(ofMesh& geometry, float size, const ofMesh& pregeom, int type);
+		void setupGeometry(Scene& scene, const vector<float>& fftValues);
+		void addGeom(const std::string& key, const std::function<shared_ptr<BaseShape>()>& generate,
+		             const ofVec3f& rotation, const ofVec3f& translation, const ofVec3f& scale);
+		void createPregeom(Scene& scene, float size, int shapeIndex, const vector<float>& fftValues);
+		void updatePregeom(glm::vec3* vertices, const Submesh& submesh, deform::Params params,
+		                   deform::Span deformed, size_t begin, size_t end);
+		void rebuildGeometry();
+
+		void buildScene(Scene& scene, const vector<float>& fftValues);
+		void applyScene(Scene& scene);
+		void applySceneGeometry(Scene& scene);
+
+		void setupOfflineRender();
+		float getFrameTime();
+		void drawScene();
 
 		void loadNextTextures();
+		void uploadSpectrum();
+		void drawShape(const glm::mat4* mirror = nullptr);
 
 		int getRandomShapeIndex();
 
-		// Container for all precomputed shapes
-    	std::vector<std::shared_ptr<BaseShape>> precomputedGeometries;
+		// All precomputed shapes, built once in setup()
+		ShapeLibrary precomputedGeometries;
+		// Recorded by addGeom(), built in parallel by generateGeometries()
+		struct ShapeRecipe {
+			std::string key;
+			std::function<shared_ptr<BaseShape>()> generate;
+			ofVec3f rotation, translation, scale;
+		};
+		std::vector<ShapeRecipe> shapeRecipes;
+		ThreadPool threadPool;
 
 		// shape we are currently rendering
 		shared_ptr<BaseShape> shapeToRender;
-		std::vector<std::pair<int, ofMesh>> submeshes;
-		ofMutex submeshMutex;
+		std::vector<Submesh> submeshes;
+		// CPU path: the current scene's mesh, deformed in place every frame
+		shared_ptr<BaseShape> frameShape;
+		// Per-frame scratch, reset at the start of every rebuild
+		FrameArena frameArena;
+		// Vertex range of one submesh, deformed by one thread pool task
+		struct DeformRange {
+			size_t submesh;
+			size_t begin, end;
+		};
+		std::vector<DeformRange> deformRanges;
+		std::vector<deform::Span> deformScratch; // per submesh, from frameArena
+		// Counted in DEBUG builds only, see AllocationCounter.h
+		uint64_t updateAllocations;
+		// Allocations of rebuildGeometry()'s tasks on other threads, its last call
+		uint64_t deformWorkerAllocations = 0;
+		size_t submeshVertexCount;
+		// sin() calls the old per-vertex offsets would have made, 3 per vertex per frame
+		uint64_t trigEvaluationsSavedPerFrame;
+		uint64_t trigEvaluationsSaved;
+		// Regenerations are built here and handed over between frames
+		SceneBuilder sceneBuilder;
+		bool sceneRequested;
 		ofColor currentColor;
+		// 'p' shows the stage timings, 't' starts and stops a Chrome trace
+		bool showProfiler;
 		ofTexture shapeTexture;
 
+		// GPU deformation: library shapes are uploaded once and drawn instanced, the FFT scale runs in the vertex shader
+		bool gpuDeform;
+		shared_ptr<DeformShape> deformShape;
+		std::map<int, shared_ptr<GpuMesh>> gpuMeshes; // by library index
+		ofShader deformShader;
+
 		ofLight pointLight;
 		ofEasyCam cam;
 
 		ofPlanePrimitive waterPlane; 
     	ofTexture waterTexture;  
 		ofShader waterShader;
-		ofImage waterImage;
-		ofFbo reflectionFbo;
+		TextureStreamer waterStreamer;
+		// Quality is set from main() before setup()
+		ReflectionQuality reflectionQuality;
+		ReflectionPass reflection;
 		ofMaterial material;
 
-		ofImage skyImage;
-		ofPlanePrimitive skyPlane;
-		ofShader skyShader;
+		TextureStreamer skyStreamer;
+		SkyPass skyPass;
 
-		// FFT stuff
+		// FFT stuff, the analysis runs on its own thread fed by audioIn()
 		int bufferSize;
-		ofxEasyFft fft;
+		ofSoundStream soundStream;
+		AudioAnalyzer analyzer;
+
+		// Offline rendering of an audio file, set from main() before setup()
+		OfflineRender offlineRender;
+		WavFile offlineAudio;
+		FrameRecorder frameRecorder;
+		ofFbo renderFbo;
+		int offlineFrame;
+		int offlineFrames;
+		float offlineStart;
 		vector<float> drawBins, middleBins, audioBins;
 
 	private: